@@ -0,0 +1,1036 @@
+/**
+ *  \file   commandline_bench.cc
+ *  \author Jason Fernandez
+ *  \date   10/16/2026
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory_resource>
+#include <new>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "commandline/commandline.h"
+#include "commandline/schema.h"
+
+namespace {
+/**
+ * The number of calls to operator new since startup
+ */
+std::atomic<std::size_t> g_allocations(0);
+
+/**
+ * The number of bytes currently allocated via operator new
+ */
+std::atomic<std::size_t> g_live_bytes(0);
+
+/**
+ * Room reserved ahead of each allocation to record its size, which keeps
+ * the returned memory suitably aligned
+ */
+constexpr std::size_t kHeaderSize = alignof(std::max_align_t);
+}  // namespace
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_live_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (void* ptr = std::malloc(size + kHeaderSize)) {
+        *static_cast<std::size_t*>(ptr) = size;
+        return static_cast<char*>(ptr) + kHeaderSize;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr == nullptr) return;
+
+    char* base = static_cast<char*>(ptr) - kHeaderSize;
+    g_live_bytes.fetch_sub(*reinterpret_cast<std::size_t*>(base),
+                           std::memory_order_relaxed);
+    std::free(base);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+// std::pmr::new_delete_resource() allocates through the aligned forms
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    const std::size_t header =
+        std::max(kHeaderSize, static_cast<std::size_t>(align));
+
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_live_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    const std::size_t total = (size + 2 * header - 1) / header * header;
+
+    if (void* ptr = std::aligned_alloc(header, total)) {
+        char* user = static_cast<char*>(ptr) + header;
+        reinterpret_cast<std::size_t*>(user)[-1] = size;
+        return user;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr, std::align_val_t align) noexcept {
+    if (ptr == nullptr) return;
+
+    const std::size_t header =
+        std::max(kHeaderSize, static_cast<std::size_t>(align));
+
+    g_live_bytes.fetch_sub(static_cast<std::size_t*>(ptr)[-1],
+                           std::memory_order_relaxed);
+    std::free(static_cast<char*>(ptr) - header);
+}
+
+void operator delete(void* ptr, std::size_t,
+                     std::align_val_t align) noexcept {
+    operator delete(ptr, align);
+}
+
+namespace {
+/**
+ * A stream buffer that discards everything written to it
+ */
+class NullBuffer final : public std::streambuf {
+protected:
+    int overflow(int c) override {
+        return c;
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize count) override {
+        return count;
+    }
+};
+
+/**
+ * Add an option whose type is chosen by its position, cycling through all
+ * twelve types supported by CommandLineOptions
+ *
+ * @param[in]  index   The position of the option
+ * @param[in]  name    The option name
+ * @param[out] options The registry to add to
+ */
+template <typename Options>
+void AddOption(std::size_t index, const std::string& name,
+               Options* options) {
+    switch (index % 12) {
+      case 0:  options->template Add<bool>(name, true); break;
+      case 1:  options->template Add<std::int8_t>(name, 1); break;
+      case 2:  options->template Add<std::int16_t>(name, 2); break;
+      case 3:  options->template Add<std::int32_t>(name, 3); break;
+      case 4:  options->template Add<std::int64_t>(name, 4); break;
+      case 5:  options->template Add<std::uint8_t>(name, 5); break;
+      case 6:  options->template Add<std::uint16_t>(name, 6); break;
+      case 7:  options->template Add<std::uint32_t>(name, 7); break;
+      case 8:  options->template Add<std::uint64_t>(name, 8); break;
+      case 9:  options->template Add<float>(name, 9.0f, "a float"); break;
+      case 10: options->template Add<double>(name, 10.0, "a double"); break;
+      default: options->template Add<std::string>(name, "eleven", "a string");
+    }
+}
+
+/**
+ * Generate option names opt0, opt1, ...
+ *
+ * @param[in] size The number of names
+ *
+ * @return The names
+ */
+std::vector<std::string> MakeNames(std::size_t size) {
+    std::vector<std::string> names;
+
+    for (std::size_t i = 0; i < size; i++)
+        names.push_back("opt" + std::to_string(i));
+
+    return names;
+}
+
+/**
+ * Build a registry with options spread across all twelve types
+ *
+ * @param[in]  names   The option names
+ * @param[out] options The registry to populate
+ */
+template <typename Options>
+void MakeRegistry(const std::vector<std::string>& names,
+                  Options* options) {
+    for (std::size_t i = 0; i < names.size(); i++)
+        AddOption(i, names[i], options);
+}
+
+/**
+ * Select the names of the int32 options in a registry built by
+ * \ref MakeRegistry()
+ *
+ * @param[in] names All option names
+ *
+ * @return Every name of type int32
+ */
+std::vector<std::string> Int32Names(const std::vector<std::string>& names) {
+    std::vector<std::string> int32_names;
+
+    for (std::size_t i = 3; i < names.size(); i += 12)
+        int32_names.push_back(names[i]);
+
+    return int32_names;
+}
+
+/**
+ * Build a command line "program --opt0=0 --opt1=1 ..."
+ *
+ * @param[in] size The number of options
+ *
+ * @return The arguments
+ */
+std::vector<std::string> MakeArgs(std::size_t size) {
+    std::vector<std::string> args = { "program" };
+
+    for (std::size_t i = 0; i < size; i++)
+        args.push_back("--opt" + std::to_string(i) + "=" + std::to_string(i));
+
+    return args;
+}
+
+void BM_GetOptVal(benchmark::State& state) {
+    std::vector<std::string> args =
+        MakeArgs(static_cast<std::size_t>(state.range(0)));
+
+    std::vector<char*> argv;
+    std::size_t bytes = 0;
+
+    for (auto& arg : args) {
+        argv.push_back(&arg[0]);
+        bytes += arg.size();
+    }
+
+    jfern::ParsedArgs parsed;
+
+    for (auto _ : state) {
+        jfern::CommandLine::GetOptVal(static_cast<int>(argv.size()),
+                                      argv.data(), parsed);
+        benchmark::DoNotOptimize(parsed.size());
+    }
+
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_GetOptVal)->RangeMultiplier(10)->Range(10, 100000);
+
+void BM_GetOptValMap(benchmark::State& state) {
+    std::vector<std::string> args =
+        MakeArgs(static_cast<std::size_t>(state.range(0)));
+
+    std::vector<char*> argv;
+    std::size_t bytes = 0;
+
+    for (auto& arg : args) {
+        argv.push_back(&arg[0]);
+        bytes += arg.size();
+    }
+
+    std::map<std::string, std::string> parsed;
+
+    for (auto _ : state) {
+        jfern::CommandLine::GetOptVal(static_cast<int>(argv.size()),
+                                      argv.data(), parsed);
+        benchmark::DoNotOptimize(parsed.size());
+    }
+
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_GetOptValMap)->RangeMultiplier(10)->Range(10, 100000);
+
+void BM_ResponseFile(benchmark::State& state) {
+    const std::vector<std::string> args =
+        MakeArgs(static_cast<std::size_t>(state.range(0)));
+
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "commandline_bench.rsp")
+            .string();
+
+    std::size_t bytes = 0;
+    {
+        std::ofstream file(path);
+        for (std::size_t i = 1; i < args.size(); i++) {
+            file << args[i] << '\n';
+            bytes += args[i].size() + 1;
+        }
+    }
+
+    std::string program = "program";
+    std::string response_file = "@" + path;
+    char* argv[] = { &program[0], &response_file[0] };
+
+    jfern::ParsedArgs parsed;
+
+    for (auto _ : state) {
+        jfern::CommandLine::GetOptVal(2, argv, parsed);
+        benchmark::DoNotOptimize(parsed.size());
+    }
+
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+
+    std::filesystem::remove(path);
+}
+
+BENCHMARK(BM_ResponseFile)->RangeMultiplier(10)->Range(10, 1000000);
+
+template <jfern::internal::DelimiterIndex::Mode mode>
+void BM_ScanDelimiters(benchmark::State& state) {
+    const std::vector<std::string> args =
+        MakeArgs(static_cast<std::size_t>(state.range(0)));
+
+    std::string text;
+    for (std::size_t i = 1; i < args.size(); i++)
+        text.append(args[i]).append(1, '\n');
+
+    for (auto _ : state) {
+        jfern::internal::DelimiterIndex index(text, mode);
+        benchmark::DoNotOptimize(index.NextNewline(0));
+    }
+
+    if (mode == jfern::internal::DelimiterIndex::Mode::kSimd)
+        state.SetLabel(jfern::internal::DelimiterIndex::SimdName());
+
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+BENCHMARK_TEMPLATE(BM_ScanDelimiters,
+                   jfern::internal::DelimiterIndex::Mode::kScalar)
+    ->RangeMultiplier(100)->Range(100, 1000000);
+BENCHMARK_TEMPLATE(BM_ScanDelimiters,
+                   jfern::internal::DelimiterIndex::Mode::kSimd)
+    ->RangeMultiplier(100)->Range(100, 1000000);
+
+void BM_Add(benchmark::State& state) {
+    const std::vector<std::string> names =
+        MakeNames(static_cast<std::size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        jfern::CommandLineOptions options;
+        MakeRegistry(names, &options);
+
+        state.PauseTiming();
+        options = jfern::CommandLineOptions();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_Add)->RangeMultiplier(10)->Range(10, 50000);
+
+void BM_Load(benchmark::State& state) {
+    const std::size_t size = static_cast<std::size_t>(state.range(0));
+    const bool use_arena = state.range(1) != 0;
+
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "commandline_bench.snapshot";
+
+    {
+        jfern::CommandLineOptions options;
+        MakeRegistry(MakeNames(size), &options);
+
+        std::ofstream stream(path, std::ios::binary);
+        options.Save(stream);
+    }
+
+    std::vector<char> buffer(256 * size + 65536);
+    std::size_t allocations = 0;
+
+    for (auto _ : state) {
+        const std::size_t allocations_before = g_allocations.load();
+
+        std::pmr::monotonic_buffer_resource arena(buffer.data(),
+                                                  buffer.size());
+        std::pmr::memory_resource* resource =
+            use_arena ? &arena : std::pmr::get_default_resource();
+
+        {
+            jfern::CommandLineOptions options(resource);
+            benchmark::DoNotOptimize(options.Load(path.string()));
+        }
+
+        allocations += g_allocations.load() - allocations_before;
+    }
+
+    std::filesystem::remove(path);
+
+    state.counters["allocs_per_load"] =
+        static_cast<double>(allocations) / state.iterations();
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_Load)->ArgsProduct({{10, 1000, 50000}, {0, 1}});
+
+void BM_AddAll(benchmark::State& state) {
+    using Options = jfern::CommandLineOptions;
+
+    const std::vector<std::string> names =
+        MakeNames(static_cast<std::size_t>(state.range(0)));
+
+    std::vector<Options::Definition<std::int32_t>> definitions;
+    for (const std::string& name : names)
+        definitions.push_back({ name, 0, "an option" });
+
+    for (auto _ : state) {
+        Options options;
+        options.AddAll<std::int32_t>(definitions.begin(), definitions.end());
+
+        state.PauseTiming();
+        options = Options();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_AddAll)->RangeMultiplier(10)->Range(10, 50000);
+
+void BM_AddEach(benchmark::State& state) {
+    const std::vector<std::string> names =
+        MakeNames(static_cast<std::size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        jfern::CommandLineOptions options;
+        for (const std::string& name : names)
+            options.Add<std::int32_t>(name, 0, "an option");
+
+        state.PauseTiming();
+        options = jfern::CommandLineOptions();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_AddEach)->RangeMultiplier(10)->Range(10, 50000);
+
+void BM_Footprint(benchmark::State& state) {
+    const std::vector<std::string> names =
+        MakeNames(static_cast<std::size_t>(state.range(0)));
+
+    std::size_t bytes = 0;
+    std::size_t allocations = 0;
+
+    for (auto _ : state) {
+        const std::size_t bytes_before       = g_live_bytes.load();
+        const std::size_t allocations_before = g_allocations.load();
+
+        jfern::CommandLineOptions options;
+        MakeRegistry(names, &options);
+
+        bytes       += g_live_bytes.load()  - bytes_before;
+        allocations += g_allocations.load() - allocations_before;
+    }
+
+    const double options = static_cast<double>(state.iterations() *
+                                               state.range(0));
+
+    state.counters["bytes_per_option"] = bytes / options;
+    state.counters["allocs_per_option"] = allocations / options;
+}
+
+BENCHMARK(BM_Footprint)->RangeMultiplier(10)->Range(10, 50000);
+
+void BM_FootprintDescribed(benchmark::State& state) {
+    const std::size_t size = static_cast<std::size_t>(state.range(0));
+
+    // Realistic names and descriptions are too long for the small-string
+    // optimization, and descriptions tend to repeat
+
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < size; i++)
+        names.push_back("service.storage.cache.option" + std::to_string(i));
+
+    const std::string descriptions[] = {
+        "Maximum number of entries held before eviction",
+        "Timeout in milliseconds for a single request",
+        "Enable verbose diagnostics for this component"
+    };
+
+    std::size_t bytes = 0;
+    std::size_t allocations = 0;
+
+    for (auto _ : state) {
+        const std::size_t bytes_before       = g_live_bytes.load();
+        const std::size_t allocations_before = g_allocations.load();
+
+        jfern::CommandLineOptions options;
+        for (std::size_t i = 0; i < size; i++)
+            options.Add<std::int32_t>(names[i], 0, descriptions[i % 3]);
+
+        bytes       += g_live_bytes.load()  - bytes_before;
+        allocations += g_allocations.load() - allocations_before;
+    }
+
+    const double options = static_cast<double>(state.iterations() * size);
+
+    state.counters["bytes_per_option"] = bytes / options;
+    state.counters["allocs_per_option"] = allocations / options;
+}
+
+BENCHMARK(BM_FootprintDescribed)->RangeMultiplier(10)->Range(10, 50000);
+
+void BM_Delete(benchmark::State& state) {
+    const std::vector<std::string> names =
+        MakeNames(static_cast<std::size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        jfern::CommandLineOptions options;
+        MakeRegistry(names, &options);
+        state.ResumeTiming();
+
+        for (const auto& name : names)
+            options.Delete(name);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_Delete)->RangeMultiplier(10)->Range(10, 50000);
+
+void BM_Churn(benchmark::State& state) {
+    const std::vector<std::string> names =
+        MakeNames(static_cast<std::size_t>(state.range(0)));
+
+    jfern::CommandLineOptions options;
+    MakeRegistry(names, &options);
+
+    if (state.range(1) != 0)
+        options.Publish(options.Stage());
+
+    // Replace a dynamic option, as a per-tenant override would
+
+    for (auto _ : state) {
+        options.Delete("tenant.limit");
+        options.Add<std::int32_t>("tenant.limit", 1);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_Churn)->ArgsProduct({{100, 10000, 50000}, {0, 1}});
+
+/**
+ * Build a 3000-option base and the names of the options a tenant overrides
+ *
+ * @param[out] options   The base options
+ * @param[out] overrides The int32 options to override
+ */
+void MakeTenantBase(jfern::CommandLineOptions* options,
+                    std::vector<std::string>* overrides) {
+    const std::vector<std::string> names = MakeNames(3000);
+    MakeRegistry(names, options);
+
+    const std::vector<std::string> ints = Int32Names(names);
+    overrides->assign(ints.begin(), ints.begin() + 30);
+}
+
+void BM_TenantCopy(benchmark::State& state) {
+    jfern::CommandLineOptions base;
+    std::vector<std::string> overrides;
+    MakeTenantBase(&base, &overrides);
+
+    for (auto _ : state) {
+        jfern::CommandLineOptions tenant(base);
+        for (const auto& name : overrides)
+            tenant.Set<std::int32_t>(name, 1);
+
+        benchmark::DoNotOptimize(tenant);
+    }
+}
+
+BENCHMARK(BM_TenantCopy);
+
+void BM_TenantOverlay(benchmark::State& state) {
+    jfern::CommandLineOptions base;
+    std::vector<std::string> overrides;
+    MakeTenantBase(&base, &overrides);
+
+    for (auto _ : state) {
+        jfern::CommandLineOptions::Overlay tenant(base);
+        for (const auto& name : overrides)
+            tenant.Set<std::int32_t>(name, 1);
+
+        benchmark::DoNotOptimize(tenant);
+    }
+}
+
+BENCHMARK(BM_TenantOverlay);
+
+void BM_OverlayGet(benchmark::State& state) {
+    jfern::CommandLineOptions base;
+    std::vector<std::string> overrides;
+    MakeTenantBase(&base, &overrides);
+
+    jfern::CommandLineOptions::Overlay tenant(base);
+    for (const auto& name : overrides)
+        tenant.Set<std::int32_t>(name, 1);
+
+    // Alternate an overridden option with one from the base
+
+    const std::string names[] = {
+        overrides.front(), Int32Names(MakeNames(3000)).back()
+    };
+
+    std::size_t i = 0;
+    std::int32_t value = 0;
+
+    for (auto _ : state) {
+        tenant.Get(names[i++ & 1], &value);
+        benchmark::DoNotOptimize(value);
+    }
+}
+
+BENCHMARK(BM_OverlayGet);
+
+void BM_Exists(benchmark::State& state) {
+    const std::vector<std::string> names =
+        MakeNames(static_cast<std::size_t>(state.range(0)));
+
+    jfern::CommandLineOptions options;
+    MakeRegistry(names, &options);
+
+    std::size_t i = 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(options.Exists(names[i]));
+        if (++i == names.size()) i = 0;
+    }
+}
+
+BENCHMARK(BM_Exists)->RangeMultiplier(10)->Range(10, 50000);
+
+void BM_Get(benchmark::State& state) {
+    const std::vector<std::string> names =
+        MakeNames(static_cast<std::size_t>(state.range(0)));
+
+    jfern::CommandLineOptions options;
+    MakeRegistry(names, &options);
+
+    const std::vector<std::string> int32_names = Int32Names(names);
+
+    std::size_t i = 0;
+    std::int32_t value = 0;
+
+    const std::size_t allocations = g_allocations.load();
+
+    for (auto _ : state) {
+        options.Get(int32_names[i], &value);
+        benchmark::DoNotOptimize(value);
+
+        if (++i == int32_names.size()) i = 0;
+    }
+
+    state.counters["allocs_per_lookup"] = benchmark::Counter(
+        static_cast<double>(g_allocations.load() - allocations),
+        benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_Get)->RangeMultiplier(10)->Range(12, 50000);
+
+void BM_Set(benchmark::State& state) {
+    const std::vector<std::string> names =
+        MakeNames(static_cast<std::size_t>(state.range(0)));
+
+    jfern::CommandLineOptions options;
+    MakeRegistry(names, &options);
+
+    const std::vector<std::string> int32_names = Int32Names(names);
+
+    std::size_t i = 0;
+    std::int32_t value = 0;
+
+    for (auto _ : state) {
+        options.Set(int32_names[i], value++);
+        if (++i == int32_names.size()) i = 0;
+    }
+}
+
+BENCHMARK(BM_Set)->RangeMultiplier(10)->Range(12, 50000);
+
+/**
+ * Options declared up front, for BM_SetFromStringSchema
+ */
+constexpr auto kBenchSchema = jfern::MakeSchema(
+    jfern::MakeOption<bool>("verbose", false),
+    jfern::MakeOption<std::int32_t>("threads", 4),
+    jfern::MakeOption<std::int32_t>("net.port", 8080),
+    jfern::MakeOption<std::int32_t>("net.backlog", 128),
+    jfern::MakeOption<std::int64_t>("storage.cache.size", 1024),
+    jfern::MakeOption<std::int64_t>("storage.cache.ttl", 60),
+    jfern::MakeOption<double>("rate", 0.5),
+    jfern::MakeOption<double>("storage.ratio", 0.75),
+    jfern::MakeOption<std::string>("host", "localhost"),
+    jfern::MakeOption<std::string>("log.path", "/tmp/log"),
+    jfern::MakeOption<std::string>("log.level", "info"),
+    jfern::MakeOption<std::uint32_t>("retries", 3));
+
+/**
+ * Resolve and assign an option from a string, as parsing does, with names
+ * looked up through a schema's perfect hash or through the name index
+ *
+ * @param[in] state The benchmark state. range(0) is nonzero to register
+ *                  the options from the schema
+ */
+void BM_SetFromStringSchema(benchmark::State& state) {
+    jfern::CommandLineOptions options;
+
+    if (state.range(0) != 0) {
+        kBenchSchema.Register(&options);
+    } else {
+        for (std::size_t i = 0; i < kBenchSchema.kSize; i++) {
+            if (kBenchSchema.Type(i) == "int32")
+                options.Add<std::int32_t>(std::string(kBenchSchema.Name(i)),
+                                          0);
+        }
+    }
+
+    const std::string_view names[] = { "threads", "net.port",
+                                       "net.backlog" };
+
+    std::size_t i = 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(options.SetFromString(names[i], "42"));
+        if (++i == 3) i = 0;
+    }
+}
+
+BENCHMARK(BM_SetFromStringSchema)->Arg(0)->Arg(1);
+
+void BM_HandleValue(benchmark::State& state) {
+    const std::vector<std::string> names =
+        MakeNames(static_cast<std::size_t>(state.range(0)));
+
+    jfern::CommandLineOptions options;
+    MakeRegistry(names, &options);
+
+    jfern::CommandLineOptions::OptionHandle<std::int32_t> handle;
+    options.Bind(Int32Names(names).back(), &handle);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(handle.Value());
+    }
+}
+
+BENCHMARK(BM_HandleValue)->RangeMultiplier(10)->Range(12, 50000);
+
+void BM_ConcurrentRead(benchmark::State& state) {
+    static jfern::ConcurrentCommandLineOptions options;
+    static jfern::ConcurrentCommandLineOptions::OptionHandle<double> ratio;
+
+    if (state.thread_index() == 0) {
+        options.Add<double>("ratio", 0.5);
+        options.Bind("ratio", &ratio);
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ratio.Value());
+    }
+
+    if (state.thread_index() == 0)
+        options.Delete("ratio");
+}
+
+BENCHMARK(BM_ConcurrentRead)->ThreadRange(1, 16);
+
+void BM_ConcurrentReadString(benchmark::State& state) {
+    static jfern::ConcurrentCommandLineOptions options;
+    static jfern::ConcurrentCommandLineOptions::OptionHandle<std::string> name;
+
+    if (state.thread_index() == 0) {
+        options.Add<std::string>("name", "a moderately long string value");
+        options.Bind("name", &name);
+    }
+
+    for (auto _ : state) {
+        std::size_t size = 0;
+        name.Read([&size](const std::string& value) { size = value.size(); });
+        benchmark::DoNotOptimize(size);
+    }
+
+    if (state.thread_index() == 0)
+        options.Delete("name");
+}
+
+BENCHMARK(BM_ConcurrentReadString)->ThreadRange(1, 16);
+
+void BM_Publish(benchmark::State& state) {
+    const std::vector<std::string> names =
+        MakeNames(static_cast<std::size_t>(state.range(0)));
+
+    jfern::ConcurrentCommandLineOptions options;
+    MakeRegistry(names, &options);
+
+    for (auto _ : state) {
+        options.Publish(options.Stage());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_Publish)->RangeMultiplier(10)->Range(12, 50000);
+
+void BM_SnapshotRead(benchmark::State& state) {
+    static jfern::ConcurrentCommandLineOptions options;
+    static jfern::ConcurrentCommandLineOptions::OptionHandle<double> ratio;
+
+    if (state.thread_index() == 0) {
+        options.Add<double>("ratio", 0.5);
+        options.Bind("ratio", &ratio);
+        options.Publish();
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(options.Current()->Value(ratio));
+    }
+
+    if (state.thread_index() == 0)
+        options.Delete("ratio");
+}
+
+BENCHMARK(BM_SnapshotRead)->ThreadRange(1, 16);
+
+void BM_Print(benchmark::State& state) {
+    const std::vector<std::string> names =
+        MakeNames(static_cast<std::size_t>(state.range(0)));
+
+    jfern::CommandLineOptions options;
+    MakeRegistry(names, &options);
+
+    NullBuffer buffer;
+    std::ostream os(&buffer);
+
+    for (auto _ : state) {
+        options.Print("program", os);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_Print)->RangeMultiplier(10)->Range(10, 50000);
+
+void BM_PrintCold(benchmark::State& state) {
+    const std::vector<std::string> names =
+        MakeNames(static_cast<std::size_t>(state.range(0)));
+
+    jfern::CommandLineOptions options;
+    MakeRegistry(names, &options);
+
+    NullBuffer buffer;
+    std::ostream os(&buffer);
+
+    for (auto _ : state) {
+        // Changing the options discards the sorted list, as at startup
+
+        state.PauseTiming();
+        options.Add<bool>("extra", false);
+        options.Delete("extra");
+        state.ResumeTiming();
+
+        options.Print("program", os);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_PrintCold)->RangeMultiplier(10)->Range(10, 50000);
+
+void BM_GetGroup(benchmark::State& state) {
+    const std::size_t size = static_cast<std::size_t>(state.range(0));
+
+    // Sixteen options per group, however large the registry
+
+    jfern::CommandLineOptions options;
+    for (std::size_t i = 0; i < size; i++) {
+        options.Add<std::int32_t>("group" + std::to_string(i / 16) +
+                                  ".opt" + std::to_string(i), 0);
+    }
+
+    std::vector<std::pair<std::string, std::string>> values;
+
+    for (auto _ : state) {
+        options.GetGroup("group0", &values);
+        benchmark::DoNotOptimize(values.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+BENCHMARK(BM_GetGroup)->RangeMultiplier(10)->Range(100, 50000);
+
+/**
+ * What a shell completion costs the program: register every option, then
+ * answer a single query
+ */
+void BM_CompleteStartup(benchmark::State& state) {
+    const std::size_t size = static_cast<std::size_t>(state.range(0));
+
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < size; i++) {
+        names.push_back("service" + std::to_string(i / 100) +
+                        ".option" + std::to_string(i));
+    }
+
+    std::string query = "--__complete=--service1.option1";
+    char program[] = "program";
+    char* argv[] = { program, &query[0] };
+
+    NullBuffer buffer;
+    std::ostream os(&buffer);
+
+    for (auto _ : state) {
+        jfern::CommandLineOptions options;
+        for (std::size_t i = 0; i < size; i++)
+            AddOption(i, names[i], &options);
+
+        jfern::CommandLine command_line(options);
+        benchmark::DoNotOptimize(command_line.complete(2, argv, os));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_Complete(benchmark::State& state) {
+    const std::size_t size = static_cast<std::size_t>(state.range(0));
+
+    jfern::CommandLineOptions options;
+    for (std::size_t i = 0; i < size; i++) {
+        AddOption(i, "service" + std::to_string(i / 100) +
+                     ".option" + std::to_string(i), &options);
+    }
+
+    std::vector<std::string> candidates;
+
+    for (auto _ : state) {
+        options.Complete("--service1.option1", &candidates);
+        benchmark::DoNotOptimize(candidates.data());
+    }
+}
+
+BENCHMARK(BM_Complete)->RangeMultiplier(10)->Range(100, 10000);
+
+BENCHMARK(BM_CompleteStartup)->RangeMultiplier(10)->Range(100, 10000)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Build a registry, parse a command line that sets every option, and tear
+ * it all down again. With an arena, the whole cycle allocates from a
+ * monotonic buffer that is released at once
+ *
+ * @param[in] state The benchmark state. range(0) is the number of options
+ *                  and range(1) is nonzero to use the arena
+ */
+void BM_ParseCycle(benchmark::State& state) {
+    const std::size_t size = static_cast<std::size_t>(state.range(0));
+    const bool use_arena = state.range(1) != 0;
+
+    const std::vector<std::string> names = MakeNames(size);
+    std::vector<std::string> args = MakeArgs(size);
+
+    std::vector<char*> argv;
+    for (auto& arg : args)
+        argv.push_back(&arg[0]);
+
+    std::vector<char> buffer(256 * size + 65536);
+    std::size_t allocations = 0;
+
+    for (auto _ : state) {
+        const std::size_t allocations_before = g_allocations.load();
+
+        std::pmr::monotonic_buffer_resource arena(buffer.data(),
+                                                  buffer.size());
+        std::pmr::memory_resource* resource =
+            use_arena ? &arena : std::pmr::get_default_resource();
+
+        {
+            jfern::CommandLineOptions options(resource);
+            for (std::size_t i = 0; i < size; i++)
+                options.Add<std::int32_t>(names[i], 0);
+
+            jfern::CommandLine command_line(options);
+            benchmark::DoNotOptimize(
+                command_line.parse(static_cast<int>(argv.size()),
+                                   argv.data()));
+        }
+
+        allocations += g_allocations.load() - allocations_before;
+    }
+
+    state.counters["allocs_per_cycle"] =
+        static_cast<double>(allocations) / state.iterations();
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_ParseCycle)->ArgsProduct({{10, 1000, 50000}, {0, 1}});
+
+/**
+ * The cycle of BM_ParseCycle with a StartupProfile recording every phase,
+ * to show what profiling costs when it is enabled. Compare BM_ParseCycle
+ * for the cost when it is not
+ *
+ * @param[in] state The benchmark state. range(0) is the number of options
+ */
+void BM_ParseCycleProfiled(benchmark::State& state) {
+    const std::size_t size = static_cast<std::size_t>(state.range(0));
+
+    const std::vector<std::string> names = MakeNames(size);
+    std::vector<std::string> args = MakeArgs(size);
+
+    std::vector<char*> argv;
+    for (auto& arg : args)
+        argv.push_back(&arg[0]);
+
+    std::uint64_t nanoseconds = 0;
+
+    for (auto _ : state) {
+        jfern::StartupProfile profile;
+
+        {
+            jfern::CommandLineOptions options(&profile);
+            for (std::size_t i = 0; i < size; i++)
+                options.Add<std::int32_t>(names[i], 0);
+
+            jfern::CommandLine command_line(options);
+            benchmark::DoNotOptimize(
+                command_line.parse(static_cast<int>(argv.size()),
+                                   argv.data()));
+        }
+
+        for (std::size_t i = 0; i < jfern::StartupProfile::kPhases; i++) {
+            nanoseconds += profile.Get(
+                static_cast<jfern::StartupProfile::Phase>(i)).nanoseconds;
+        }
+    }
+
+    state.counters["profiled_ns"] =
+        static_cast<double>(nanoseconds) / state.iterations();
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_ParseCycleProfiled)->Arg(10)->Arg(1000)->Arg(50000);
+
+}  // namespace
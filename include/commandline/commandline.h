@@ -10,13 +10,29 @@
 #define COMMAND_LINE_H_
 
 #include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 #include <cstddef>
 #include <cstdint>  //yes
+#include <cstring>
 #include <ostream> // yes
 #include <string> // yes
+#include <string_view>
+#include <thread>
 #include <tuple> // yes
 #include <type_traits> // yes
+#include <unordered_map>
+#include <unordered_set>
 #include <utility> // yes
 #include <vector> // yes
 
@@ -24,10 +40,6 @@
 //#include "util/str_util.h"
 //#include "util/traits.h"
 
-// ---
-
-#include "superstring/superstring.h"
-
 namespace jfern {
 namespace internal {
 /**
@@ -90,6 +102,43 @@ struct TypeToName<std::string> {
  * @}
  */
 
+/**
+ * Check if a character is whitespace
+ *
+ * @param[in] c The character to check
+ *
+ * @return True if \a c is whitespace
+ */
+inline bool IsSpace(char c) noexcept {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+/**
+ * Check if a string is empty or pure whitespace. Unlike trimming, this does
+ * not allocate
+ *
+ * @param[in] str The string to check
+ *
+ * @return True if the string is blank
+ */
+inline bool IsBlank(std::string_view str) noexcept {
+    return std::all_of(str.begin(), str.end(), IsSpace);
+}
+
+/**
+ * Remove leading and trailing whitespace from a view
+ *
+ * @param[in] str The string to trim
+ *
+ * @return The trimmed view
+ */
+inline std::string_view Trim(std::string_view str) noexcept {
+    while (!str.empty() && IsSpace(str.front())) str.remove_prefix(1);
+    while (!str.empty() && IsSpace(str.back()))  str.remove_suffix(1);
+
+    return str;
+}
+
 /**
  * Converts a value to its string representation. This simply wraps
  * std::to_string, with specializations for bool and string
@@ -122,748 +171,5273 @@ enum class CmdLineError {
     kDuplicate,       ///< Duplicate option name
     kEmptyName,       ///< Option name is an empty string
     kInvalidCmdLine,  ///< Command line is ill-formed
+    kInvalidConfig,   ///< Config file is missing or ill-formed
+    kInvalidValue,    ///< Value cannot be converted to the option's type
+    kOutOfRange,      ///< Value does not fit in the option's type
     kWrongType,       ///< Option has a different type
     kSuccess          ///< Completed successfully
 };
 
+namespace internal {
 /**
- * Class that builds a table of command line options
+ * Converts a string to a value of a supported type. Numbers are parsed with
+ * std::from_chars, which is locale-independent and does not allocate
+ *
+ * @param[in]  str   The string to convert
+ * @param[out] value The converted value. Unmodified on error
+ *
+ * @return A \ref CmdLineError return code
+ *
+ * @{
  */
-template <typename... Ts>
-class UserOptions final {
-public:
-    UserOptions() = default;
-
-    UserOptions(const UserOptions& opts)            = default;
-    UserOptions(UserOptions&& opts)                 = default;
-    UserOptions& operator=(const UserOptions& opts) = default;
-    UserOptions& operator=(UserOptions&& opts)      = default;
-
-    ~UserOptions() = default;
-
-    template <typename T>
-    CmdLineError Add(const std::string& name,
-                     const T& default_value,
-                     const std::string& desc = "");
-
-    template <typename T>
-    CmdLineError Default(const std::string& name, T* value) const;
-
-    CmdLineError Delete(const std::string& name);
-
-    bool Exists(const std::string& name) const;
-
-    template <typename T>
-    CmdLineError Get(const std::string& name, T* value) const;
-
-    template <typename T>
-    CmdLineError Set(const std::string& name, const T& value);
-
-    void Print(const char* prog_name, std::ostream& os) const;
-
-    template <typename T>
-    static constexpr bool IsSupported() noexcept;
-
-private:
-    template <typename U>
-    CmdLineError Delete_(const std::string& name);
-
-    template <typename U1, typename U2, typename... Us>
-    CmdLineError Delete_(const std::string& name);
-
-    template <typename U>
-    bool Exists_(const std::string& name) const;
-
-    template <typename U1, typename U2, typename... Us>
-    bool Exists_(const std::string& name) const;
-
-    template <typename T>
-    static constexpr bool IsSupported_() noexcept;
-
-    template <typename T, typename U, typename... Us>
-    static constexpr bool IsSupported_() noexcept;
-
-    /**
-     * Base class for a generic command line option
-     */
-    class Option {
-    public:
-        Option(const std::string& name,
-               const std::string& type,
-               const std::string& description);
-
-        Option(const Option& opt)            = default;
-        Option(Option&& opt)                 = default;
-        Option& operator=(const Option& opt) = default;
-        Option& operator=(Option&& opt)      = default;
-
-        virtual ~Option() = default;
-
-        /**
-         * Get the default value of this option
-         *
-         * @return The string representation of this option's default
-         */
-        virtual std::string Default() const = 0;
-
-        /**
-         * Get the current value of this option
-         *
-         * @return The string representation of this option's current
-         *         value
-         */
-        virtual std::string Value() const = 0;
-
-        std::string Description() const;
+template <typename T>
+CmdLineError FromString(std::string_view str, T* value) {
+    static_assert(std::is_arithmetic<T>::value, "Non-supported type");
 
-        std::string Name() const;
+    str = Trim(str);
 
-        void Print(std::ostream& os) const;
+    const char* last = str.data() + str.size();
 
-        std::string Type() const;
+    T result;
+    const std::from_chars_result status =
+        std::from_chars(str.data(), last, result);
 
-    protected:
-        /**
-         * A description for this option
-         */
-        std::string description_;
+    if (status.ec == std::errc::result_out_of_range)
+        return CmdLineError::kOutOfRange;
 
-        /**
-         * The name of this option
-         */
-        std::string name_;
+    if (status.ec != std::errc() || status.ptr != last)
+        return CmdLineError::kInvalidValue;
 
-        /**
-         * The human-readable type of option
-         */
-        std::string type_;
+    *value = result;
+    return CmdLineError::kSuccess;
+}
+template <>
+inline CmdLineError FromString<bool>(std::string_view str, bool* value) {
+    auto equals = [](std::string_view str1, std::string_view str2) {
+        return std::equal(str1.begin(), str1.end(), str2.begin(), str2.end(),
+            [](char c1, char c2) {
+                return std::tolower(static_cast<unsigned char>(c1)) == c2;
+            });
     };
 
-    /**
-     * Represents a command line option
-     *
-     * @tparam T The type of this command line option
-     */
-    template <typename T>
-    class TypedOption final : public Option {
-    public:
-        using ValueType = T;
-
-        TypedOption(const std::string& name,
-                    const std::string& description,
-                    const ValueType& default_value);
-
-        TypedOption(const TypedOption& opt)            = default;
-        TypedOption(TypedOption&& opt)                 = default;
-        TypedOption& operator=(const TypedOption& opt) = default;
-        TypedOption& operator=(TypedOption&& opt)      = default;
-
-        ~TypedOption() = default;
+    str = Trim(str);
 
-        void Assign(const ValueType& value) noexcept;
+    /*
+     * Note: An empty value means the option was given without one, e.g.
+     *       --option, which is understood as setting the flag
+     */
+    if (str.empty() || str == "1" || equals(str, "true")) {
+        *value = true; return CmdLineError::kSuccess;
+    }
 
-        ValueType CurrentValue() const noexcept;
+    if (str == "0" || equals(str, "false")) {
+        *value = false; return CmdLineError::kSuccess;
+    }
 
-        std::string Default() const override;
+    return CmdLineError::kInvalidValue;
+}
+template <>
+inline CmdLineError FromString<std::string>(std::string_view str,
+                                            std::string* value) {
+    value->assign(str.data(), str.size());
+    return CmdLineError::kSuccess;
+}
+/**
+ * @}
+ */
 
-        ValueType DefaultValue() const noexcept;
+}  // namespace internal
 
-        std::string Value() const override;
+namespace internal {
+/**
+ * Make room in a vector for more elements. Unlike calling reserve() with
+ * the exact size needed, this keeps growth geometric, so that reserving
+ * for many small batches in turn takes linear time overall
+ *
+ * @param[in]     count  The number of elements that will be added
+ * @param[in,out] vector The vector
+ */
+template <typename T, typename Allocator>
+void ReserveMore(std::size_t count, std::vector<T, Allocator>* vector) {
+    if (vector->capacity() - vector->size() < count) {
+        vector->reserve(std::max(vector->size() + count,
+                                 2 * vector->capacity()));
+    }
+}
 
-    private:
-        /**
-         * This option's default value
-         */
-        ValueType default_;
+/**
+ * Hash a string (64-bit FNV-1a followed by a finalizer, so that the low bits
+ * are well mixed)
+ *
+ * @param[in] str The string to hash
+ *
+ * @return The hash value
+ */
+constexpr std::uint64_t HashName(std::string_view str) noexcept {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : str) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
 
-        /**
-         * This option's current value
-         */
-        ValueType value_;
-    };
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
 
-    template <typename U>
-    std::vector<const Option*> Accumulate_() const;
+    return hash;
+}
 
-    template <typename U1, typename U2, typename... Us>
-    std::vector<const Option*> Accumulate_() const;
+/**
+ * Identifies a binary snapshot written by BasicUserOptions::Save()
+ */
+constexpr char kBlobMagic[8] = { 'C', 'M', 'D', 'L', 'I', 'N', 'E', '\0' };
 
-    std::vector<const Option*> Accumulate () const;
+/**
+ * The version of the binary snapshot format. Bump this whenever the layout
+ * changes
+ */
+constexpr std::uint32_t kBlobVersion = 1;
 
-    template <typename T>
-    typename std::vector<TypedOption<T>>::const_iterator
-    Find(const std::string& name, bool* valid) const;
+/**
+ * Written as is, so that a snapshot from a machine of the other byte order
+ * is recognized and rejected
+ */
+constexpr std::uint32_t kBlobByteOrder = 0x01020304;
 
-    template <typename T>
-    typename std::vector<TypedOption<T>>::iterator
-    Load(const std::string& name, bool* valid);
+/**
+ * The start of a binary snapshot. A snapshot is laid out as
+ *
+ * @code
+ * BlobHeader
+ * for each supported type, in order:
+ *     std::uint64_t       count
+ *     BlobEntry           entries[count]
+ *     BlobValue<T>::type  defaults[count]
+ *     BlobValue<T>::type  values[count]
+ * char                    pool[pool_size]
+ * @endcode
+ *
+ * in the byte order of the machine that wrote it. Strings are stored once
+ * in the pool and referred to by \ref BlobString
+ */
+struct BlobHeader {
+    char          magic[8];    ///< \ref kBlobMagic
+    std::uint32_t version;     ///< \ref kBlobVersion
+    std::uint32_t byte_order;  ///< \ref kBlobByteOrder
+    std::uint64_t types;       ///< A hash of the supported types, in order
+    std::uint64_t schema;      ///< The fingerprint given to Save()
+    std::uint64_t pool;        ///< The offset of the string pool
+    std::uint64_t pool_size;   ///< The size of the string pool, in bytes
+};
 
-    /**
-     * Container for a set of options of the same type
-     */
-    template <typename T>
-    using OptionSet = std::vector<TypedOption<T>>;
+/**
+ * A string within the pool of a binary snapshot
+ */
+struct BlobString {
+    std::uint32_t offset;  ///< The offset of the string within the pool
+    std::uint32_t size;    ///< The length of the string
+};
 
-    /**
-     * The complete set of available command line options
-     */
-    std::tuple<OptionSet<Ts>...>
-        options_;
+/**
+ * The name and description of an option within a binary snapshot
+ */
+struct BlobEntry {
+    BlobString name;         ///< The option name
+    BlobString description;  ///< A description of the option
 };
 
 /**
- * Alias representing all types supported by this library
+ * How an option value is stored within a binary snapshot
+ *
+ * @{
+ */
+template <typename T>
+struct BlobValue {
+    using type = T;
+};
+template <>
+struct BlobValue<bool> {
+    using type = std::uint8_t;
+};
+template <>
+struct BlobValue<std::string> {
+    using type = BlobString;
+};
+/**
+ * @}
  */
-using CommandLineOptions = UserOptions<bool,
-                                       std::int8_t,
-                                       std::int16_t,
-                                       std::int32_t,
-                                       std::int64_t,
-                                       std::uint8_t,
-                                       std::uint16_t,
-                                       std::uint32_t,
-                                       std::uint64_t,
-                                       float,
-                                       double,
-                                       std::string>;
 
 /**
- * A class that parses the command line and maintains a record of options. Only
- * supports long options
+ * Reads fixed-size fields in turn from a binary snapshot, which need not be
+ * aligned
  */
-class CommandLine {
+class BlobReader final {
 public:
+    /**
+     * Constructor
+     *
+     * @param[in] data The bytes to read
+     */
+    explicit BlobReader(std::string_view data) noexcept : data_(data) {
+    }
 
-    explicit CommandLine(const CommandLineOptions& options);
-    ~CommandLine();
+    /**
+     * Read the next field
+     *
+     * @param[out] value The field
+     *
+     * @return False if there are too few bytes left
+     */
+    template <typename T>
+    bool Read(T* value) noexcept {
+        if (data_.size() < sizeof(T)) return false;
 
+        std::memcpy(value, data_.data(), sizeof(T));
+        data_.remove_prefix(sizeof(T));
+
+        return true;
+    }
 
-#if 0
     /**
-     * Retrieve the value of a command line option. Either this is
-     * its default or the command line value
+     * Skip over some fields
      *
-     * @tparam T The type of the option
-     *
-     * @param[in]  _name The name of the command line option. This
-     *                   is case-insensitive
-     * @param[out] value The value of this option
+     * @param[in] size The number of bytes to skip
      *
-     * @return True on success
+     * @return False if there are too few bytes left
      */
-    template<typename T>
-    bool get(const std::string& _name, T& value) const
-    {
-        AbortIfNot(_options.get<T>(_name, value),
-            false);
+    bool Skip(std::size_t size) noexcept {
+        if (data_.size() < size) return false;
 
+        data_.remove_prefix(size);
         return true;
     }
-#endif
-    bool parse(int argc, char** argv);
-
-    CommandLine(const CommandLine& rhs) = delete;
-    CommandLine&
-      operator=(const CommandLine& rhs) = delete;
 
-    static bool GetOptVal(int argc, char** argv,
-                          std::map<std::string, std::string>& opt_val);
+    /**
+     * Get the number of bytes left to read
+     *
+     * @return The number of bytes
+     */
+    std::size_t Remaining() const noexcept {
+        return data_.size();
+    }
 
 private:
-    static bool NextPair(const std::string& str,
-                         std::size_t* p_start,
-                         std::size_t* p_equal);
-    
-
-    UserOptions<bool>&
-        _options;
+    /**
+     * The bytes not yet read
+     */
+    std::string_view data_;
 };
 
 /**
- * Add a new command line option which is settable via the command line
- *
- * @tparam T The type of the option
- *
- * @param[in] name          The name of the option to add
- * @param[in] default_value The default value to assign the option
- * @param[in] desc          A description for the option
+ * Append a fixed-size field to a binary snapshot
  *
- * @return A \ref CmdLineError return code
+ * @param[in]     value The field
+ * @param[in,out] blob  The snapshot
  */
-template <typename... Ts>
 template <typename T>
-CmdLineError UserOptions<Ts...>::Add(const std::string& name,
-                                     const T& default_value,
-                                     const std::string& desc) {
-    const std::string trimmed = superstring(name).trim();
-
-    if (trimmed.empty()) return CmdLineError::kEmptyName;
-    if (Exists(name)) return CmdLineError::kDuplicate;
+void AppendBlob(const T& value, std::string* blob) {
+    blob->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
 
-    std::vector<TypedOption<T>>& options = std::get<OptionSet<T>>(options_);
+/**
+ * Add a string to the pool of a binary snapshot
+ *
+ * @param[in]     str  The string
+ * @param[in,out] pool The pool
+ * @param[out]    out  Where the string was stored
+ *
+ * @return False if the pool would grow beyond 4 GiB
+ */
+inline bool PoolString(std::string_view str, std::string* pool,
+                       BlobString* out) {
+    if (pool->size() + str.size() > UINT32_MAX) return false;
 
-    options.push_back(TypedOption<T>(name, desc, default_value));
+    out->offset = static_cast<std::uint32_t>(pool->size());
+    out->size   = static_cast<std::uint32_t>(str.size());
 
-    return CmdLineError::kSuccess;
+    pool->append(str.data(), str.size());
+    return true;
 }
 
 /**
- * Get the default value of an option
- * 
- * @param[in]  name  The name of the option
- * @param[out] value The default value of this option
- * 
- * @return A \ref CmdLineError return code
+ * Look up a string in the pool of a binary snapshot
+ *
+ * @param[in]  pool The pool
+ * @param[in]  str  Where the string is stored
+ * @param[out] out  The string
+ *
+ * @return False if the string lies outside the pool
  */
-template <typename... Ts>
-template <typename T>
-CmdLineError
-UserOptions<Ts...>::Default(const std::string& name, T* value) const {
-    const std::string trimmed = superstring(name).trim();
+inline bool PoolString(std::string_view pool, const BlobString& str,
+                       std::string_view* out) noexcept {
+    if (str.offset > pool.size() || str.size > pool.size() - str.offset)
+        return false;
 
-    if (trimmed.empty())
+    *out = pool.substr(str.offset, str.size);
+    return true;
+}
+
+/**
+ * Write an option value to a binary snapshot
+ *
+ * @param[in]     value The value
+ * @param[in,out] blob  The snapshot
+ * @param[in,out] pool  The snapshot's string pool
+ *
+ * @return False if the pool is full
+ *
+ * @{
+ */
+template <typename T>
+bool AppendValue(const T& value, std::string* blob, std::string*) {
+    AppendBlob(value, blob);
+    return true;
+}
+template <>
+inline bool AppendValue<bool>(const bool& value, std::string* blob,
+                              std::string*) {
+    AppendBlob(static_cast<std::uint8_t>(value ? 1 : 0), blob);
+    return true;
+}
+template <>
+inline bool AppendValue<std::string>(const std::string& value,
+                                     std::string* blob, std::string* pool) {
+    BlobString str;
+    if (!PoolString(value, pool, &str)) return false;
+
+    AppendBlob(str, blob);
+    return true;
+}
+/**
+ * @}
+ */
+
+/**
+ * Read an option value from a binary snapshot
+ *
+ * @param[in,out] reader The snapshot, positioned at the value
+ * @param[in]     pool   The snapshot's string pool
+ * @param[out]    value  The value
+ *
+ * @return False if the value is truncated or ill-formed
+ *
+ * @{
+ */
+template <typename T>
+bool ReadValue(BlobReader* reader, std::string_view, T* value) {
+    return reader->Read(value);
+}
+template <>
+inline bool ReadValue<bool>(BlobReader* reader, std::string_view,
+                            bool* value) {
+    std::uint8_t stored;
+    if (!reader->Read(&stored) || stored > 1) return false;
+
+    *value = stored != 0;
+    return true;
+}
+template <>
+inline bool ReadValue<std::string>(BlobReader* reader, std::string_view pool,
+                                   std::string* value) {
+    BlobString stored;
+    std::string_view str;
+
+    if (!reader->Read(&stored) || !PoolString(pool, stored, &str))
+        return false;
+
+    value->assign(str.data(), str.size());
+    return true;
+}
+/**
+ * @}
+ */
+
+/**
+ * Storage for strings that live as long as a set of options. Strings are
+ * copied into large blocks, and each distinct string is stored only once,
+ * so that adding an option rarely allocates for its name or description.
+ * Strings are never freed individually. Copies of an arena share the blocks
+ * written so far, so views into them remain valid in either copy. Blocks
+ * come from the arena's memory resource, which must outlive every copy
+ */
+class StringArena final {
+public:
+    StringArena();
+
+    explicit StringArena(std::pmr::memory_resource* resource);
+
+    StringArena(const StringArena& arena);
+    StringArena(StringArena&& arena) noexcept;
+    StringArena& operator=(const StringArena& arena);
+    StringArena& operator=(StringArena&& arena);
+
+    ~StringArena() = default;
+
+    void Adopt(std::shared_ptr<char[]> block);
+
+    std::string_view Intern(std::string_view str);
+
+    std::string_view InternStored(std::string_view str);
+
+    void Reserve(std::size_t count);
+
+private:
+    char* Allocate(std::size_t size);
+
+    char* AllocateBlock(std::size_t size);
+
+    std::string_view Insert(std::string_view str, bool copy);
+
+    void Rehash(std::size_t size);
+
+    /**
+     * The size of the first block. Each block after it is twice the size of
+     * the last, up to \ref kMaxBlockSize
+     */
+    static constexpr std::size_t kMinBlockSize = 512;
+
+    /**
+     * The largest size of a block. Strings longer than a quarter of this get
+     * a block of their own
+     */
+    static constexpr std::size_t kMaxBlockSize = 16384;
+
+    /**
+     * Where new blocks and the hash table are allocated
+     */
+    std::pmr::memory_resource* resource_;
+
+    /**
+     * Every block allocated by, or shared with, this arena
+     */
+    std::pmr::vector<std::shared_ptr<char[]>> blocks_;
+
+    /**
+     * The free space in the current block
+     */
+    char* next_ = nullptr;
+
+    /**
+     * The number of free bytes at \ref next_
+     */
+    std::size_t remaining_ = 0;
+
+    /**
+     * The size of the most recent regular block
+     */
+    std::size_t block_size_ = 0;
+
+    /**
+     * Open-addressed hash table of the stored strings; empty views mark
+     * free slots
+     */
+    std::pmr::vector<std::string_view> table_;
+
+    /**
+     * The number of strings in \ref table_
+     */
+    std::size_t count_ = 0;
+};
+
+/**
+ * A radix tree of option names, for listing every name that begins with a
+ * given prefix in sorted order. Each edge is labeled with a view of one of
+ * the names, so the names must stay alive for as long as they are in the
+ * tree, as interned names do
+ */
+class PrefixIndex final {
+public:
+    PrefixIndex();
+
+    explicit PrefixIndex(std::pmr::memory_resource* resource);
+
+    PrefixIndex(const PrefixIndex& index)            = default;
+    PrefixIndex(PrefixIndex&& index)                 = default;
+    PrefixIndex& operator=(const PrefixIndex& index) = default;
+    PrefixIndex& operator=(PrefixIndex&& index)      = default;
+
+    ~PrefixIndex() = default;
+
+    void Collect(std::string_view prefix,
+                 std::pmr::vector<std::string_view>* names) const;
+
+    void Erase(std::string_view name);
+
+    void Insert(std::string_view name);
+
+    void Reserve(std::size_t count);
+
+private:
+    /**
+     * Marks the absence of a node
+     */
+    static constexpr std::uint32_t kNone = 0xffffffff;
+
+    /**
+     * A node of the tree. A name ends at a node if it is marked terminal,
+     * in which case its label is the tail of that name
+     */
+    struct Node {
+        std::string_view label;         ///< The edge into this node
+        std::uint32_t    first_child;   ///< The child with the least label
+        std::uint32_t    next_sibling;  ///< The next child of the parent
+        bool             terminal;      ///< True if a name ends here
+    };
+
+    std::uint32_t Child(std::uint32_t node, char c) const noexcept;
+
+    void Collect_(std::uint32_t node,
+                  std::size_t depth,
+                  std::pmr::vector<std::string_view>* names) const;
+
+    void Free(std::uint32_t node);
+
+    std::uint32_t NewNode(std::string_view label, bool terminal);
+
+    void Link(std::uint32_t parent, std::uint32_t child);
+
+    void Merge(std::uint32_t node);
+
+    void Unlink(std::uint32_t parent, std::uint32_t child);
+
+    /**
+     * All nodes. The root, at index 0, has an empty label
+     */
+    std::pmr::vector<Node> nodes_;
+
+    /**
+     * Nodes no longer in the tree, for reuse
+     */
+    std::pmr::vector<std::uint32_t> free_;
+};
+
+}  // namespace internal
+
+/**
+ * Threading policy for \ref BasicUserOptions in which option values are not
+ * synchronized. Nor are the indexes that \ref BasicUserOptions::Print() and
+ * \ref BasicUserOptions::Stage() build on first use, so not even calls to
+ * const methods may overlap. This is the default
+ */
+struct SingleThreaded {};
+
+/**
+ * Threading policy for \ref BasicUserOptions in which option values may be
+ * set by one thread while any number of others read them. Readers never
+ * block. Adding and deleting options must still not overlap other calls
+ */
+struct Concurrent {};
+
+namespace internal {
+/**
+ * Storage for the current value of an option, synchronized according to a
+ * threading policy. Without synchronization, the value is held directly
+ *
+ * @tparam T         The type of the value
+ * @tparam Threading \ref SingleThreaded or \ref Concurrent
+ */
+template <typename T, typename Threading, typename Enable = void>
+class ValueCell final {
+public:
+    explicit ValueCell(const T& value) : value_(value) {
+    }
+
+    /**
+     * Get the value
+     *
+     * @return A copy of the value
+     */
+    T Load() const {
+        return value_;
+    }
+
+    /**
+     * Pass the value to a function, without copying it
+     *
+     * @param[in] reader Invoked with a const reference to the value
+     */
+    template <typename F>
+    void Read(F&& reader) const {
+        reader(value_);
+    }
+
+    /**
+     * Set the value
+     *
+     * @param[in] value The new value
+     */
+    void Store(const T& value) {
+        value_ = value;
+    }
+
+private:
+    /**
+     * The value
+     */
+    T value_;
+};
+
+/**
+ * Concurrent storage for a number, which is held in a lock-free atomic
+ */
+template <typename T>
+class ValueCell<T, Concurrent,
+                typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    final {
+public:
+    static_assert(std::atomic<T>::is_always_lock_free,
+                  "Concurrent values must be lock-free");
+
+    explicit ValueCell(const T& value) : value_(value) {
+    }
+
+    ValueCell(const ValueCell& cell) : value_(cell.Load()) {
+    }
+
+    ValueCell& operator=(const ValueCell& cell) {
+        Store(cell.Load()); return *this;
+    }
+
+    /**
+     * @see ValueCell::Load
+     */
+    T Load() const noexcept {
+        return value_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @see ValueCell::Read
+     */
+    template <typename F>
+    void Read(F&& reader) const {
+        reader(Load());
+    }
+
+    /**
+     * @see ValueCell::Store
+     */
+    void Store(const T& value) noexcept {
+        value_.store(value, std::memory_order_release);
+    }
+
+private:
+    /**
+     * The value
+     */
+    std::atomic<T> value_;
+};
+
+/**
+ * Concurrent storage for any other value, such as a string. Each new value
+ * is published by swapping a pointer, and the old value is freed once every
+ * reader that might still see it has left (a minimal form of RCU). Readers
+ * announce themselves on one of two counters selected by an epoch which
+ * each writer advances, so that a writer only waits for readers that began
+ * before its swap
+ */
+template <typename T>
+class ValueCell<T, Concurrent,
+                typename std::enable_if<!std::is_arithmetic<T>::value>::type>
+    final {
+public:
+    explicit ValueCell(const T& value);
+
+    ValueCell(const ValueCell& cell);
+
+    ValueCell& operator=(const ValueCell& cell);
+
+    ~ValueCell();
+
+    T Load() const;
+
+    template <typename F>
+    void Read(F&& reader) const;
+
+    void Store(const T& value);
+
+private:
+    /**
+     * The published value
+     */
+    std::atomic<const T*> current_;
+
+    /**
+     * Advanced by each writer; its low bit selects the reader counter
+     */
+    std::atomic<std::uint64_t> epoch_;
+
+    /**
+     * The number of readers that entered during even and odd epochs
+     */
+    mutable std::atomic<std::size_t> readers_[2];
+
+    /**
+     * Serializes writers
+     */
+    std::atomic_flag writing_ = ATOMIC_FLAG_INIT;
+};
+
+/**
+ * Constructor
+ *
+ * @param[in] value The initial value
+ */
+template <typename T>
+ValueCell<T, Concurrent,
+          typename std::enable_if<!std::is_arithmetic<T>::value>::type>::
+    ValueCell(const T& value)
+    : current_(new T(value)), epoch_(0), readers_{{0}, {0}} {
+}
+
+/**
+ * Copy constructor. Must not overlap a write to \a cell
+ *
+ * @param[in] cell The cell to copy
+ */
+template <typename T>
+ValueCell<T, Concurrent,
+          typename std::enable_if<!std::is_arithmetic<T>::value>::type>::
+    ValueCell(const ValueCell& cell)
+    : ValueCell(*cell.current_.load()) {
+}
+
+/**
+ * Copy assignment operator. Safe to call while other threads read this
+ * cell, but must not overlap a write to \a cell
+ *
+ * @param[in] cell The cell to copy
+ *
+ * @return *this
+ */
+template <typename T>
+auto ValueCell<T, Concurrent,
+               typename std::enable_if<!std::is_arithmetic<T>::value>::type>::
+    operator=(const ValueCell& cell) -> ValueCell& {
+    if (this != &cell) Store(*cell.current_.load());
+    return *this;
+}
+
+/**
+ * Destructor
+ */
+template <typename T>
+ValueCell<T, Concurrent,
+          typename std::enable_if<!std::is_arithmetic<T>::value>::type>::
+    ~ValueCell() {
+    delete current_.load();
+}
+
+/**
+ * Get a copy of the current value
+ *
+ * @return The value
+ */
+template <typename T>
+T ValueCell<T, Concurrent,
+            typename std::enable_if<!std::is_arithmetic<T>::value>::type>::
+    Load() const {
+    T value;
+    Read([&value](const T& current) { value = current; });
+
+    return value;
+}
+
+/**
+ * Pass the current value to a function without copying it. This never
+ * blocks or allocates; it retries only if a writer advances the epoch
+ * while the reader is announcing itself
+ *
+ * @param[in] reader Invoked with a const reference to the value, which is
+ *                   valid only for the duration of the call
+ */
+template <typename T>
+template <typename F>
+void ValueCell<T, Concurrent,
+               typename std::enable_if<!std::is_arithmetic<T>::value>::type>::
+    Read(F&& reader) const {
+    for (;;) {
+        const std::uint64_t epoch = epoch_.load();
+        std::atomic<std::size_t>& readers = readers_[epoch & 1];
+
+        readers.fetch_add(1);
+
+        if (epoch_.load() == epoch) {
+            struct Exit {
+                std::atomic<std::size_t>& readers;
+                ~Exit() { readers.fetch_sub(1, std::memory_order_release); }
+            } exit{readers};
+
+            reader(*current_.load());
+            return;
+        }
+
+        readers.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+/**
+ * Publish a new value. Waits for readers of the previous value to leave
+ * before freeing it
+ *
+ * @param[in] value The new value
+ */
+template <typename T>
+void ValueCell<T, Concurrent,
+               typename std::enable_if<!std::is_arithmetic<T>::value>::type>::
+    Store(const T& value) {
+    const T* next = new T(value);
+
+    while (writing_.test_and_set(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    const T* previous = current_.exchange(next);
+
+    /*
+     * Readers arriving from now on see the new value and count themselves
+     * under the new epoch. Wait out those counted under the old one.
+     *
+     * The count must be loaded seq_cst: a reader increments its count and
+     * then rereads the epoch, while this bumps the epoch and then reads the
+     * count. Only the single total order guarantees one side sees the
+     * other. With acquire, the load may complete before the increment is
+     * visible (on ARMv8.3 an LDAPR can pass the preceding STLXR), so both
+     * sides miss each other and previous is freed under the reader
+     */
+    const std::uint64_t epoch = epoch_.fetch_add(1);
+
+    while (readers_[epoch & 1].load() != 0)
+        std::this_thread::yield();
+
+    writing_.clear(std::memory_order_release);
+
+    delete previous;
+}
+
+}  // namespace internal
+
+/**
+ * Opt-in instrumentation of startup, recording the time spent in each phase
+ * of registering options and parsing the command line, and what each phase
+ * allocates. Attach a profile with BasicUserOptions::SetProfile(), or build
+ * the options on one, which also counts their allocations: a profile is a
+ * memory resource that forwards to another. Without a profile, no clock is
+ * read and nothing is counted
+ *
+ * Phases do not nest. Time and allocations within a phase are charged to
+ * it alone, and allocations outside every phase are not counted. A profile
+ * is not thread-safe; it is meant for the thread that starts a program up
+ */
+class StartupProfile final : public std::pmr::memory_resource {
+public:
+    /**
+     * A phase of startup
+     */
+    enum class Phase {
+        kRegister,  ///< Adding or loading options
+        kTokenize,  ///< Splitting arguments or a config file into option,
+                    ///< value pairs
+        kResolve,   ///< Looking up options by name
+        kConvert,   ///< Converting and range-checking values
+        kAssign     ///< Storing values and notifying listeners
+    };
+
+    /**
+     * The number of phases
+     */
+    static constexpr std::size_t kPhases = 5;
+
+    /**
+     * What was recorded for a phase
+     */
+    struct Counters {
+        std::uint64_t calls       = 0;  ///< Times the phase was entered
+        std::uint64_t nanoseconds = 0;  ///< Time spent in the phase
+        std::uint64_t allocations = 0;  ///< Allocations made in the phase
+        std::uint64_t bytes       = 0;  ///< Bytes allocated in the phase
+    };
+
+    /**
+     * Times a phase from construction until \ref Stop() or destruction
+     */
+    class Timer final {
+    public:
+        Timer(StartupProfile* profile, Phase phase) noexcept;
+
+        Timer(const Timer& timer)            = delete;
+        Timer& operator=(const Timer& timer) = delete;
+
+        ~Timer();
+
+        void Stop() noexcept;
+
+    private:
+        /**
+         * The profile to charge, or null if this is not timing
+         */
+        StartupProfile* profile_;
+
+        /**
+         * When the phase began
+         */
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    StartupProfile();
+
+    explicit StartupProfile(std::pmr::memory_resource* upstream);
+
+    StartupProfile(const StartupProfile& profile)            = delete;
+    StartupProfile& operator=(const StartupProfile& profile) = delete;
+
+    ~StartupProfile() = default;
+
+    const Counters& Get(Phase phase) const noexcept;
+
+    static const char* Name(Phase phase) noexcept;
+
+    void Report(std::ostream& os) const;
+
+    void Reset() noexcept;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+    void do_deallocate(void* p,
+                       std::size_t bytes,
+                       std::size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource& other)
+        const noexcept override;
+
+    /**
+     * Marks the absence of a phase in \ref active_
+     */
+    static constexpr std::size_t kIdle = kPhases;
+
+    /**
+     * Where allocations are forwarded
+     */
+    std::pmr::memory_resource* upstream_;
+
+    /**
+     * The phase being timed, or \ref kIdle
+     */
+    std::size_t active_ = kIdle;
+
+    /**
+     * What was recorded, by phase
+     */
+    Counters counters_[kPhases];
+};
+
+/**
+ * Start timing a phase, unless there is no profile or it is already timing
+ * another phase
+ *
+ * @param[in] profile The profile to charge, or null to do nothing
+ * @param[in] phase   The phase to time
+ */
+inline StartupProfile::Timer::Timer(StartupProfile* profile,
+                                    Phase phase) noexcept
+    : profile_(nullptr), start_() {
+    if (profile == nullptr || profile->active_ != kIdle) return;
+
+    profile_ = profile;
+    profile_->active_ = static_cast<std::size_t>(phase);
+    start_ = std::chrono::steady_clock::now();
+}
+
+/**
+ * Destructor. Stops timing
+ */
+inline StartupProfile::Timer::~Timer() {
+    Stop();
+}
+
+/**
+ * Stop timing, charging the time elapsed to the phase. Does nothing if
+ * already stopped
+ */
+inline void StartupProfile::Timer::Stop() noexcept {
+    if (profile_ == nullptr) return;
+
+    const auto elapsed = std::chrono::steady_clock::now() - start_;
+
+    Counters& counters = profile_->counters_[profile_->active_];
+    counters.calls++;
+    counters.nanoseconds += static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+            .count());
+
+    profile_->active_ = kIdle;
+    profile_ = nullptr;
+}
+
+template <typename... Ts>
+class Schema;
+
+/**
+ * Class that builds a table of command line options. The option table,
+ * names, descriptions and published snapshots are allocated from a
+ * std::pmr::memory_resource, the default resource unless one is given, so
+ * that the options may live in an arena and be released all at once. The
+ * resource must outlive the options and any copy constructed from them,
+ * which allocates from the same resource. Assigning options that allocate
+ * from another resource copies their names and descriptions into this one
+ */
+template <typename Threading, typename... Ts>
+class BasicUserOptions final {
+public:
+    BasicUserOptions();
+
+    explicit BasicUserOptions(std::pmr::memory_resource* resource);
+
+    explicit BasicUserOptions(StartupProfile* profile);
+
+    BasicUserOptions(const BasicUserOptions& opts);
+    BasicUserOptions(BasicUserOptions&& opts)                 = default;
+    BasicUserOptions& operator=(const BasicUserOptions& opts);
+    BasicUserOptions& operator=(BasicUserOptions&& opts);
+
+    ~BasicUserOptions() = default;
+
+    template <typename T>
+    class OptionHandle;
+
+    class Snapshot;
+
+    class Overlay;
+
+    class Batch;
+
+    /**
+     * Receives the names of the options that changed, in sorted order
+     */
+    using Listener = std::function<void(const std::vector<std::string>&)>;
+
+    /**
+     * Runs a notification task on whichever thread should deliver it
+     */
+    using Dispatcher = std::function<void(std::function<void()>)>;
+
+    /**
+     * An option to add via \ref AddAll()
+     *
+     * @tparam T The type of the option
+     */
+    template <typename T>
+    struct Definition {
+        std::string_view name;           ///< The option name
+        T                default_value;  ///< The default value
+        std::string_view description{};  ///< A description of the option
+    };
+
+    template <typename T>
+    CmdLineError Add(const std::string& name,
+                     const T& default_value,
+                     const std::string& desc = "");
+
+    template <typename T, typename Iterator>
+    CmdLineError AddAll(Iterator first, Iterator last);
+
+    void BeginBatch() noexcept;
+
+    template <typename T>
+    CmdLineError Default(const std::string& name, T* value) const;
+
+    template <typename T>
+    CmdLineError Bind(const std::string& name, OptionHandle<T>* handle) const;
+
+    void Complete(std::string_view word,
+                  std::vector<std::string>* candidates) const;
+
+    std::shared_ptr<const Snapshot> Current() const;
+
+    CmdLineError Delete(const std::string& name);
+
+    void EndBatch();
+
+    bool Exists(const std::string& name) const;
+
+    template <typename T>
+    CmdLineError Get(const std::string& name, T* value) const;
+
+    CmdLineError GetGroup(
+        const std::string& group,
+        std::vector<std::pair<std::string, std::string>>* values) const;
+
+    CmdLineError Load(const std::string& path, std::uint64_t schema = 0);
+
+    std::vector<std::string> Names(std::string_view prefix =
+                                       std::string_view()) const;
+
+    CmdLineError Restore(std::string_view blob, std::uint64_t schema = 0);
+
+    CmdLineError Save(std::ostream& os, std::uint64_t schema = 0) const;
+
+    template <typename T>
+    CmdLineError Set(const std::string& name, const T& value);
+
+    template <typename T, typename Iterator>
+    CmdLineError SetAll(Iterator first, Iterator last);
+
+    void SetDispatcher(Dispatcher dispatcher);
+
+    CmdLineError SetFromString(std::string_view name,
+                               std::string_view value);
+
+    void SetProfile(StartupProfile* profile) noexcept;
+
+    void Print(const char* prog_name,
+               std::ostream& os,
+               std::string_view prefix = std::string_view()) const;
+
+    StartupProfile* Profile() const noexcept;
+
+    void Publish();
+
+    void Publish(Snapshot&& snapshot);
+
+    void Reserve(std::size_t count);
+
+    CmdLineError ResetGroup(const std::string& group);
+
+    std::pmr::memory_resource* Resource() const noexcept;
+
+    Snapshot Stage() const;
+
+    CmdLineError Subscribe(const std::string& name,
+                           Listener listener,
+                           std::size_t* id = nullptr);
+
+    std::size_t SubscribeGroup(const std::string& group, Listener listener);
+
+    CmdLineError Unsubscribe(std::size_t id);
+
+    template <typename T>
+    static constexpr bool IsSupported() noexcept;
+
+private:
+    /**
+     * The location of an option within \ref options_
+     */
+    struct Slot {
+        std::size_t type;   ///< Index of the option's type within Ts...
+        std::size_t index;  ///< Index into the OptionSet for that type
+    };
+
+    /**
+     * A listener registered via \ref Subscribe() or \ref SubscribeGroup()
+     */
+    struct Subscriber {
+        std::size_t id;        ///< Identifies this subscription
+        std::string name;      ///< The option or group name
+        bool        group;     ///< True if \a name is a group
+        Listener    listener;  ///< Invoked with the changed options
+    };
+
+    friend class CommandLine;
+
+    void AbortBatch() noexcept;
+
+    void Dispatch();
+
+    void Notify(std::string_view name);
+
+    void Reintern(const BasicUserOptions& opts);
+
+    template <typename U>
+    void Reintern_();
+
+    template <typename U1, typename U2, typename... Us>
+    void Reintern_();
+
+    template <typename U>
+    void Delete_(const Slot& slot);
+
+    template <typename U1, typename U2, typename... Us>
+    void Delete_(const Slot& slot);
+
+    template <typename T>
+    static constexpr bool IsSupported_() noexcept;
+
+    template <typename T, typename U, typename... Us>
+    static constexpr bool IsSupported_() noexcept;
+
+    void Commit(Snapshot&& snapshot);
+
+    template <typename U>
+    void Publish_(const Snapshot& snapshot);
+
+    template <typename U1, typename U2, typename... Us>
+    void Publish_(const Snapshot& snapshot);
+
+    template <typename U>
+    CmdLineError SetFromString_(const Slot& slot, std::string_view value);
+
+    template <typename U1, typename U2, typename... Us>
+    CmdLineError SetFromString_(const Slot& slot, std::string_view value);
+
+    static std::string GroupPrefix(std::string_view group);
+
+    template <typename U>
+    void Complete_(const Slot& slot,
+                   std::string_view value,
+                   std::vector<std::string>* candidates) const;
+
+    template <typename U1, typename U2, typename... Us>
+    void Complete_(const Slot& slot,
+                   std::string_view value,
+                   std::vector<std::string>* candidates) const;
+
+    template <typename U>
+    void Reset_(const Slot& slot);
+
+    template <typename U1, typename U2, typename... Us>
+    void Reset_(const Slot& slot);
+
+    template <typename U>
+    std::string ToString_(const Slot& slot) const;
+
+    template <typename U1, typename U2, typename... Us>
+    std::string ToString_(const Slot& slot) const;
+
+    template <typename U>
+    void Stage_(Snapshot* snapshot) const;
+
+    template <typename U1, typename U2, typename... Us>
+    void Stage_(Snapshot* snapshot) const;
+
+    CmdLineError Load_(std::string_view blob,
+                       std::uint64_t schema,
+                       std::shared_ptr<char[]> block);
+
+    template <typename U>
+    CmdLineError Load_(internal::BlobReader* reader,
+                       std::string_view pool,
+                       bool stored,
+                       std::pmr::vector<std::string_view>* checked);
+
+    template <typename U1, typename U2, typename... Us>
+    CmdLineError Load_(internal::BlobReader* reader,
+                       std::string_view pool,
+                       bool stored,
+                       std::pmr::vector<std::string_view>* checked);
+
+    template <typename U>
+    bool Save_(std::string* blob, std::string* pool) const;
+
+    template <typename U1, typename U2, typename... Us>
+    bool Save_(std::string* blob, std::string* pool) const;
+
+    static std::uint64_t TypesHash() noexcept;
+
+    template <typename T>
+    static constexpr std::size_t TypeIndex() noexcept;
+
+    template <typename T>
+    static constexpr std::size_t TypeIndex_() noexcept;
+
+    template <typename T, typename U, typename... Us>
+    static constexpr std::size_t TypeIndex_() noexcept;
+
+    /**
+     * A view of a single option, for printing
+     */
+    struct OptionInfo {
+        std::string_view name;           ///< The option name
+        std::string_view description{};  ///< A description of the option
+        const char*      type;           ///< The human-readable type
+        std::string      default_value;  ///< The default, as a string
+    };
+
+    /**
+     * Every option sorted by name, with its default rendered, as needed by
+     * \ref Print(). Built on first use and discarded when an option is
+     * added or deleted
+     */
+    using HelpIndex = std::pmr::vector<OptionInfo>;
+
+    template <typename U>
+    void Accumulate_(HelpIndex* options) const;
+
+    template <typename U>
+    OptionInfo Describe_(const Slot& slot) const;
+
+    template <typename U1, typename U2, typename... Us>
+    OptionInfo Describe_(const Slot& slot) const;
+
+    template <typename U1, typename U2, typename... Us>
+    void Accumulate_(HelpIndex* options) const;
+
+    std::shared_ptr<const HelpIndex> Help() const;
+
+    /**
+     * A copy of every option name and its location, so that a snapshot
+     * does not depend on the options that staged it. Built on first use
+     * and discarded when an option is added or deleted
+     */
+    struct NameIndex {
+        explicit NameIndex(std::pmr::memory_resource* resource);
+
+        NameIndex(const NameIndex& index,
+                  std::pmr::memory_resource* resource);
+
+        std::pmr::string                                names;  ///< Storage
+        std::pmr::unordered_map<std::string_view, Slot> slots;  ///< Lookup
+    };
+
+    std::shared_ptr<const NameIndex> Index() const;
+
+    template <typename T>
+    std::size_t Find(std::string_view name, CmdLineError* error) const;
+
+    const Slot* Locate(std::string_view name) const;
+
+    template <typename... Us>
+    friend class Schema;
+
+    void BindSchema(std::shared_ptr<const void> schema,
+                    std::size_t (*find)(const void*, std::string_view),
+                    const std::string_view* names,
+                    std::size_t count);
+
+    /**
+     * Container for a set of options of the same type. Each field is kept in
+     * an array of its own, so that reading values touches only the values,
+     * packed together. Names and descriptions are cold: they are needed only
+     * to print and complete options
+     *
+     * Options never move. Each occupies a slot, at the same index in every
+     * array; deleting an option clears its slot, bumps the slot's version
+     * and leaves the slot for the next \ref Add() to reuse. Indexes held by
+     * \ref index_, handles and snapshots therefore stay put, and a version
+     * tells them apart from a later option in the same slot
+     *
+     * @tparam T The type of the options
+     */
+    template <typename T>
+    class OptionSet final {
+    public:
+        using ValueType = T;
+
+        explicit OptionSet(std::pmr::memory_resource* resource);
+
+        OptionSet(const OptionSet& options)            = default;
+        OptionSet(OptionSet&& options)                 = default;
+        OptionSet& operator=(const OptionSet& options) = default;
+        OptionSet& operator=(OptionSet&& options)      = default;
+
+        ~OptionSet() = default;
+
+        std::size_t Add(std::string_view name,
+                        std::string_view description,
+                        const ValueType& default_value);
+
+        bool Assign(std::size_t index, const ValueType& value)
+            noexcept(std::is_trivially_copyable<T>::value);
+
+        ValueType CurrentValue(std::size_t index) const
+            noexcept(std::is_trivially_copyable<T>::value);
+
+        ValueType DefaultValue(std::size_t index) const
+            noexcept(std::is_trivially_copyable<T>::value);
+
+        std::string_view Description(std::size_t index) const noexcept;
+
+        std::string_view Name(std::size_t index) const noexcept;
+
+        bool Live(std::size_t index) const noexcept;
+
+        template <typename F>
+        void ReadValue(std::size_t index, F&& reader) const;
+
+        void Reintern(internal::StringArena* strings);
+
+        void Remove(std::size_t index);
+
+        void Reserve(std::size_t count);
+
+        std::size_t Size() const noexcept;
+
+        std::size_t Slots() const noexcept;
+
+        std::uint32_t Version(std::size_t index) const noexcept;
+
+    private:
+        /**
+         * The current value of each option
+         */
+        std::pmr::vector<internal::ValueCell<ValueType, Threading>> values_;
+
+        /**
+         * The default value of each option
+         */
+        std::pmr::vector<ValueType> defaults_;
+
+        /**
+         * The name of each option, interned in the owner's arena
+         */
+        std::pmr::vector<std::string_view> names_;
+
+        /**
+         * The description of each option, interned in the owner's arena
+         */
+        std::pmr::vector<std::string_view> descriptions_;
+
+        /**
+         * The number of times each slot has been emptied
+         */
+        std::pmr::vector<std::uint32_t> versions_;
+
+        /**
+         * Empty slots, the most recently emptied last
+         */
+        std::pmr::vector<std::size_t> free_;
+    };
+
+public:
+    /**
+     * A typed reference to a single option, obtained via \ref Bind(). Reading
+     * through a handle involves no name lookup, string work or type check.
+     * Handles remain valid across \ref Add() and across deleting other
+     * options. Deleting the bound option invalidates the handle, which
+     * \ref Valid() then reports; moving the owning BasicUserOptions
+     * invalidates every handle
+     *
+     * @tparam T The type of the option
+     */
+    template <typename T>
+    class OptionHandle final {
+    public:
+        OptionHandle() = default;
+
+        OptionHandle(const OptionHandle& handle)            = default;
+        OptionHandle(OptionHandle&& handle)                 = default;
+        OptionHandle& operator=(const OptionHandle& handle) = default;
+        OptionHandle& operator=(OptionHandle&& handle)      = default;
+
+        ~OptionHandle() = default;
+
+        T Default() const noexcept(std::is_trivially_copyable<T>::value);
+
+        template <typename F>
+        void Read(F&& reader) const;
+
+        bool Valid() const noexcept;
+
+        T Value() const noexcept(std::is_trivially_copyable<T>::value);
+
+    private:
+        friend class BasicUserOptions;
+        friend class Overlay;
+        friend class Snapshot;
+
+        OptionHandle(const OptionSet<T>* options, std::size_t index);
+
+        /**
+         * The options of type T
+         */
+        const OptionSet<T>* options_ = nullptr;
+
+        /**
+         * The index of this option within \ref options_
+         */
+        std::size_t index_ = 0;
+
+        /**
+         * The version of the option's slot when this handle was bound
+         */
+        std::uint32_t version_ = 0;
+    };
+
+    /**
+     * The slot versions of the options of one type, as of a snapshot
+     */
+    template <typename T>
+    using Versions = std::pmr::vector<std::uint32_t>;
+
+    /**
+     * A copy of every option value, obtained via \ref Stage(). Once passed
+     * to \ref Publish(), a snapshot is immutable and is shared by all
+     * readers of \ref Current(), who therefore see either all of the old
+     * values or all of the new ones. A snapshot keeps its own copy of the
+     * option names, so it may outlive the options that staged it, and
+     * still holds options deleted since it was staged
+     */
+    class Snapshot final {
+    public:
+        Snapshot(const Snapshot& snapshot)            = default;
+        Snapshot(Snapshot&& snapshot)                 = default;
+        Snapshot& operator=(const Snapshot& snapshot) = default;
+        Snapshot& operator=(Snapshot&& snapshot)      = default;
+
+        ~Snapshot() = default;
+
+        std::uint64_t Generation() const noexcept;
+
+        template <typename T>
+        CmdLineError Get(const std::string& name, T* value) const;
+
+        template <typename T>
+        CmdLineError Set(const std::string& name, const T& value);
+
+        CmdLineError SetFromString(std::string_view name,
+                                   std::string_view value);
+
+        template <typename T>
+        T Value(const OptionHandle<T>& handle) const;
+
+    private:
+        friend class BasicUserOptions;
+
+        explicit Snapshot(const BasicUserOptions* owner);
+
+        Snapshot(const Snapshot& snapshot,
+                 std::pmr::memory_resource* resource);
+
+        template <typename T>
+        std::size_t Locate(const std::string& name,
+                           CmdLineError* error) const;
+
+        template <typename U>
+        bool Staged(std::size_t index, std::uint32_t version) const noexcept;
+
+        template <typename U>
+        CmdLineError SetFromString_(const Slot& slot,
+                                    std::string_view value);
+
+        template <typename U1, typename U2, typename... Us>
+        CmdLineError SetFromString_(const Slot& slot,
+                                    std::string_view value);
+
+        /**
+         * The name and location of each option, as of staging
+         */
+        std::shared_ptr<const NameIndex> names_;
+
+        /**
+         * The number of snapshots published before and including this one
+         */
+        std::uint64_t generation_;
+
+        /**
+         * The value of each option, at the same index as in \ref options_
+         */
+        std::tuple<std::pmr::vector<Ts>...> values_;
+
+        /**
+         * The version of each slot in \ref values_, by type
+         */
+        std::tuple<Versions<Ts>...> versions_;
+    };
+
+    /**
+     * A sparse set of overrides layered over shared options, such as one
+     * tenant's settings over a process-wide base. Reads of options that are
+     * not overridden fall through to the base, and writes never reach it,
+     * so creating or copying an overlay costs only as much as its overrides.
+     * The base must outlive the overlay. An overlay is not thread-safe
+     */
+    class Overlay final {
+    public:
+        explicit Overlay(const BasicUserOptions& base);
+
+        Overlay(const BasicUserOptions& base,
+                std::pmr::memory_resource* resource);
+
+        Overlay(const Overlay& overlay)            = default;
+        Overlay(Overlay&& overlay)                 = default;
+        Overlay& operator=(const Overlay& overlay) = default;
+        Overlay& operator=(Overlay&& overlay)      = default;
+
+        ~Overlay() = default;
+
+        template <typename T>
+        CmdLineError Get(const std::string& name, T* value) const;
+
+        bool Overridden(std::string_view name) const;
+
+        CmdLineError Reset(std::string_view name);
+
+        template <typename T>
+        CmdLineError Set(const std::string& name, const T& value);
+
+        CmdLineError SetFromString(std::string_view name,
+                                   std::string_view value);
+
+        std::size_t Size() const noexcept;
+
+        template <typename T>
+        T Value(const OptionHandle<T>& handle) const;
+
+    private:
+        /**
+         * An overridden value, and the version of the base option's slot
+         * when it was set
+         */
+        template <typename T>
+        struct Override {
+            T             value;    ///< The value in this overlay
+            std::uint32_t version;  ///< The slot version of the option
+        };
+
+        /**
+         * The overrides of options of one type, by slot index
+         */
+        template <typename T>
+        using Overrides = std::pmr::unordered_map<std::size_t, Override<T>>;
+
+        template <typename T>
+        const Override<T>* Find(std::size_t index) const;
+
+        template <typename U>
+        bool Overridden_(const Slot& slot) const;
+
+        template <typename U1, typename U2, typename... Us>
+        bool Overridden_(const Slot& slot) const;
+
+        template <typename U>
+        CmdLineError Reset_(const Slot& slot);
+
+        template <typename U1, typename U2, typename... Us>
+        CmdLineError Reset_(const Slot& slot);
+
+        template <typename U>
+        CmdLineError SetFromString_(const Slot& slot,
+                                    std::string_view value);
+
+        template <typename U1, typename U2, typename... Us>
+        CmdLineError SetFromString_(const Slot& slot,
+                                    std::string_view value);
+
+        template <typename U>
+        std::size_t Size_() const noexcept;
+
+        template <typename U1, typename U2, typename... Us>
+        std::size_t Size_() const noexcept;
+
+        /**
+         * The options beneath this overlay
+         */
+        const BasicUserOptions* base_;
+
+        /**
+         * The overridden options, by type
+         */
+        std::tuple<Overrides<Ts>...> overrides_;
+    };
+
+    /**
+     * Holds change notifications for as long as it is in scope, as between
+     * \ref BeginBatch() and \ref EndBatch(). If the scope is left by an
+     * exception, the held notifications are dropped rather than delivered
+     */
+    class Batch final {
+    public:
+        explicit Batch(BasicUserOptions* options) noexcept;
+
+        Batch(const Batch& batch)            = delete;
+        Batch& operator=(const Batch& batch) = delete;
+
+        ~Batch() noexcept(false);
+
+    private:
+        /**
+         * The options whose notifications are held
+         */
+        BasicUserOptions* options_;
+
+        /**
+         * The number of exceptions in flight when the batch was opened
+         */
+        int exceptions_;
+    };
+
+private:
+    /**
+     * The complete set of available command line options
+     */
+    std::tuple<OptionSet<Ts>...>
+        options_;
+
+    /**
+     * Option names and descriptions
+     */
+    internal::StringArena
+        strings_;
+
+    /**
+     * Maps each option name to its location in \ref options_
+     */
+    std::pmr::unordered_map<std::string_view, Slot>
+        index_;
+
+    /**
+     * The option names, for listing those in a group
+     */
+    internal::PrefixIndex
+        groups_;
+
+    /**
+     * The schema the options were registered from, if any. Its perfect hash
+     * resolves names ahead of \ref index_
+     */
+    std::shared_ptr<const void>
+        schema_;
+
+    /**
+     * Looks up a name in \ref schema_, giving its position in the schema or
+     * a position past the end if it is not there
+     */
+    std::size_t (*schema_find_)(const void*, std::string_view) = nullptr;
+
+    /**
+     * The location of each option in \ref schema_, by position. An option
+     * since deleted has a type of sizeof...(Ts)
+     */
+    std::pmr::vector<Slot>
+        schema_slots_;
+
+    /**
+     * The number of snapshots published so far
+     */
+    std::uint64_t
+        generation_ = 0;
+
+    /**
+     * Listeners for option changes
+     */
+    std::vector<Subscriber>
+        subscribers_;
+
+    /**
+     * The ID to give the next subscriber
+     */
+    std::size_t
+        next_id_ = 0;
+
+    /**
+     * Options changed since the last dispatch, which may repeat
+     */
+    std::vector<std::string>
+        pending_;
+
+    /**
+     * The number of open batches; notifications are held until it is zero
+     */
+    std::size_t
+        batch_depth_ = 0;
+
+    /**
+     * Delivers notifications, or empty to deliver them on the thread that
+     * made the change
+     */
+    Dispatcher
+        dispatcher_;
+
+    /**
+     * The most recently published snapshot, if any
+     */
+    internal::ValueCell<std::shared_ptr<const Snapshot>, Threading>
+        snapshot_{nullptr};
+
+    /**
+     * The sorted options for \ref Print(), if built
+     */
+    mutable internal::ValueCell<std::shared_ptr<const HelpIndex>, Threading>
+        help_{nullptr};
+
+    /**
+     * The option names for snapshots, if built
+     */
+    mutable internal::ValueCell<std::shared_ptr<const NameIndex>, Threading>
+        names_{nullptr};
+
+    /**
+     * Records the time spent in each phase of startup, if attached
+     */
+    StartupProfile*
+        profile_ = nullptr;
+};
+
+/**
+ * A table of command line options with unsynchronized values
+ */
+template <typename... Ts>
+using UserOptions = BasicUserOptions<SingleThreaded, Ts...>;
+
+/**
+ * A table of command line options whose values may be set while other
+ * threads read them
+ */
+template <typename... Ts>
+using ConcurrentUserOptions = BasicUserOptions<Concurrent, Ts...>;
+
+/**
+ * Alias representing all types supported by this library
+ */
+using CommandLineOptions = UserOptions<bool,
+                                       std::int8_t,
+                                       std::int16_t,
+                                       std::int32_t,
+                                       std::int64_t,
+                                       std::uint8_t,
+                                       std::uint16_t,
+                                       std::uint32_t,
+                                       std::uint64_t,
+                                       float,
+                                       double,
+                                       std::string>;
+
+/**
+ * Alias representing all types supported by this library, with values that
+ * may be set while other threads read them
+ */
+using ConcurrentCommandLineOptions = ConcurrentUserOptions<bool,
+                                                           std::int8_t,
+                                                           std::int16_t,
+                                                           std::int32_t,
+                                                           std::int64_t,
+                                                           std::uint8_t,
+                                                           std::uint16_t,
+                                                           std::uint32_t,
+                                                           std::uint64_t,
+                                                           float,
+                                                           double,
+                                                           std::string>;
+
+namespace internal {
+/**
+ * A read-only memory mapping of an entire file
+ */
+class MappedFile final {
+public:
+    MappedFile() = default;
+
+    MappedFile(const MappedFile& file)            = delete;
+    MappedFile(MappedFile&& file) noexcept;
+    MappedFile& operator=(const MappedFile& file) = delete;
+    MappedFile& operator=(MappedFile&& file) noexcept;
+
+    ~MappedFile();
+
+    std::string_view Contents() const noexcept;
+
+    bool Open(const std::string& path);
+
+private:
+    void Close() noexcept;
+
+    /**
+     * The start of the mapping
+     */
+    const char* data_ = nullptr;
+
+    /**
+     * The size of the file, in bytes
+     */
+    std::size_t size_ = 0;
+};
+
+/**
+ * Bitmaps of the newlines and equals signs in a block of text, built in a
+ * single pass. Blocks of 64 bytes are compared at once using AVX2 or SSE2
+ * where the compiler targets them, so that long response and config files
+ * are split into lines and name, value pairs without a byte-by-byte search
+ */
+class DelimiterIndex final {
+public:
+    /**
+     * How to scan the text
+     */
+    enum class Mode {
+        kScalar,  ///< One byte at a time
+        kSimd     ///< The widest vector instructions available
+    };
+
+    explicit DelimiterIndex(std::string_view text, Mode mode = Mode::kSimd,
+                            std::pmr::memory_resource* resource =
+                                std::pmr::get_default_resource());
+
+    DelimiterIndex(const DelimiterIndex& index)            = default;
+    DelimiterIndex(DelimiterIndex&& index)                 = default;
+    DelimiterIndex& operator=(const DelimiterIndex& index) = default;
+    DelimiterIndex& operator=(DelimiterIndex&& index)      = default;
+
+    ~DelimiterIndex() = default;
+
+    std::size_t NextEqual(std::size_t pos, std::size_t end) const noexcept;
+
+    std::size_t NextNewline(std::size_t pos) const noexcept;
+
+    static const char* SimdName() noexcept;
+
+private:
+    static std::size_t Next(const std::pmr::vector<std::uint64_t>& bits,
+                            std::size_t pos,
+                            std::size_t end) noexcept;
+
+    /**
+     * Bit i of word w is set if byte 64w+i is an '='
+     */
+    std::pmr::vector<std::uint64_t> equals_;
+
+    /**
+     * Bit i of word w is set if byte 64w+i is a '\n'
+     */
+    std::pmr::vector<std::uint64_t> newlines_;
+};
+
+}  // namespace internal
+
+/**
+ * The option, value pairs parsed from a command line. Names and values are
+ * views into the original argv buffers or into response files mapped by
+ * this object; they are stored contiguously and sorted by name once parsing
+ * is complete. The argv buffers must outlive this object. Anything this
+ * object allocates comes from its memory resource
+ */
+class ParsedArgs final {
+public:
+    /**
+     * A single option, value pair
+     */
+    using value_type = std::pair<std::string_view, std::string_view>;
+
+    using const_iterator = std::pmr::vector<value_type>::const_iterator;
+
+    ParsedArgs();
+
+    explicit ParsedArgs(std::pmr::memory_resource* resource);
+
+    ParsedArgs(const ParsedArgs& args)            = delete;
+    ParsedArgs(ParsedArgs&& args)                 = default;
+    ParsedArgs& operator=(const ParsedArgs& args) = delete;
+    ParsedArgs& operator=(ParsedArgs&& args);
+
+    ~ParsedArgs() = default;
+
+    const_iterator begin() const noexcept;
+
+    void clear() noexcept;
+
+    bool empty() const noexcept;
+
+    const_iterator end() const noexcept;
+
+    const_iterator Find(std::string_view name) const;
+
+    std::size_t size() const noexcept;
+
+private:
+    friend class CommandLine;
+
+    void Append(std::string_view name, std::string_view value);
+
+    void Append(std::pmr::string&& name, std::string_view value);
+
+    void Continue(std::string_view value);
+
+    void Finalize();
+
+    std::pmr::memory_resource* Resource() const noexcept;
+
+    /**
+     * All option, value pairs, sorted by name after parsing
+     */
+    std::pmr::vector<value_type> pairs_;
+
+    /**
+     * Backing storage for the rare names and values that cannot be viewed
+     * in place, such as values spanning several arguments or config keys
+     * qualified by their section. A deque never relocates these
+     */
+    std::pmr::deque<std::pmr::string> joined_;
+
+    /**
+     * Response files referenced by the command line, which remain mapped
+     * for as long as their contents are viewed
+     */
+    std::pmr::vector<internal::MappedFile> files_;
+};
+
+/**
+ * A class that parses the command line and maintains a record of options. Only
+ * supports long options
+ */
+class CommandLine {
+public:
+    /**
+     * An option that could not be applied by \ref parse()
+     */
+    struct OptionError {
+        std::string  name;   ///< The option name, empty if the command
+                             ///< line itself was ill-formed
+        CmdLineError error;  ///< Why the option was rejected
+    };
+
+    /**
+     * A shell for which to generate a completion script
+     */
+    enum class Shell {
+        kBash,  ///< GNU bash
+        kZsh    ///< Z shell
+    };
+
+    template <typename Threading, typename... Ts>
+    explicit CommandLine(BasicUserOptions<Threading, Ts...>& options);
+
+    ~CommandLine();
+
+
+#if 0
+    /**
+     * Retrieve the value of a command line option. Either this is
+     * its default or the command line value
+     *
+     * @tparam T The type of the option
+     *
+     * @param[in]  _name The name of the command line option. This
+     *                   is case-insensitive
+     * @param[out] value The value of this option
+     *
+     * @return True on success
+     */
+    template<typename T>
+    bool get(const std::string& _name, T& value) const
+    {
+        AbortIfNot(_options.get<T>(_name, value),
+            false);
+
+        return true;
+    }
+#endif
+    bool parse(int argc, char** argv);
+
+    bool parse(int argc, char** argv, const std::string& config);
+
+    bool reload(const std::string& config);
+
+    bool complete(int argc, char** argv, std::ostream& os) const;
+
+    static void completion_script(Shell shell,
+                                  const std::string& prog_name,
+                                  std::ostream& os);
+
+    CommandLine(const CommandLine& rhs) = delete;
+    CommandLine&
+      operator=(const CommandLine& rhs) = delete;
+
+    static bool GetOptVal(int argc, char** argv,
+                          std::map<std::string, std::string>& opt_val);
+
+    static bool GetOptVal(int argc, char** argv, ParsedArgs& args);
+
+    static bool GetConfigVal(const std::string& path, ParsedArgs& args);
+
+    const std::vector<OptionError>& Errors() const noexcept;
+
+private:
+    class ProfileScope;
+
+    void Apply(const ParsedArgs& args, bool command_line);
+
+    bool Tokenize(int argc, char** argv,
+                  ProfileScope* profiling,
+                  std::optional<ParsedArgs>* args);
+
+    static bool ParseArg(std::string_view arg,
+                         std::size_t equal,
+                         const std::string& dir,
+                         std::vector<std::string>* files,
+                         ParsedArgs& args);
+
+    static bool ParseFile(std::string_view name,
+                          const std::string& dir,
+                          std::vector<std::string>* files,
+                          ParsedArgs& args);
+
+    /**
+     * A step in the life of a batch of changes to \ref options_
+     */
+    enum class BatchStep {
+        kBegin,  ///< Open a batch
+        kEnd,    ///< Close a batch, delivering its notifications
+        kAbort   ///< Close a batch left by an exception
+    };
+
+    class ScopedBatch;
+
+    template <typename Options>
+    static void Batch(void* options, BatchStep step);
+
+    template <typename Options>
+    static void Complete(const void* options,
+                         std::string_view word,
+                         std::vector<std::string>* candidates);
+
+    template <typename Options>
+    static StartupProfile* Profile(const void* options);
+
+    template <typename Options>
+    static void Reload(void* options,
+                       const ParsedArgs& args,
+                       std::vector<OptionError>* errors);
+
+    template <typename Options>
+    static void SetProfile(void* options, StartupProfile* profile);
+
+    template <typename Options>
+    static CmdLineError SetFromString(void* options,
+                                      std::string_view name,
+                                      std::string_view value);
+
+    /**
+     * The options to assign from the command line
+     */
+    void*
+        options_;
+
+    /**
+     * Assigns one of \ref options_ from its string representation
+     */
+    CmdLineError (*set_from_string_)(void*,
+                                     std::string_view,
+                                     std::string_view);
+
+    /**
+     * Opens or closes a batch of changes to \ref options_
+     */
+    void (*batch_)(void*, BatchStep);
+
+    /**
+     * Suggests completions of a command line argument
+     */
+    void (*complete_)(const void*,
+                      std::string_view,
+                      std::vector<std::string>*);
+
+    /**
+     * Stages a set of values for \ref options_ and publishes them as a
+     * whole
+     */
+    void (*reload_)(void*,
+                    const ParsedArgs&,
+                    std::vector<OptionError>*);
+
+    /**
+     * Gets the profile attached to \ref options_
+     */
+    StartupProfile* (*profile_)(const void*);
+
+    /**
+     * Attaches a profile to \ref options_
+     */
+    void (*set_profile_)(void*, StartupProfile*);
+
+    /**
+     * The memory resource of \ref options_, from which parsing allocates
+     */
+    std::pmr::memory_resource*
+        resource_;
+
+    /**
+     * Per-option errors from the most recent call to \ref parse()
+     */
+    std::vector<OptionError>
+        errors_;
+};
+
+/**
+ * Constructor
+ *
+ * @param[in] options The options to assign from the command line. These
+ *                    must outlive this object. Parsing allocates from their
+ *                    memory resource
+ */
+template <typename Threading, typename... Ts>
+CommandLine::CommandLine(BasicUserOptions<Threading, Ts...>& options)
+    : options_(&options),
+      set_from_string_(&SetFromString<BasicUserOptions<Threading, Ts...>>),
+      batch_(&Batch<BasicUserOptions<Threading, Ts...>>),
+      complete_(&Complete<BasicUserOptions<Threading, Ts...>>),
+      reload_(&Reload<BasicUserOptions<Threading, Ts...>>),
+      profile_(&Profile<BasicUserOptions<Threading, Ts...>>),
+      set_profile_(&SetProfile<BasicUserOptions<Threading, Ts...>>),
+      resource_(options.Resource()),
+      errors_() {
+}
+
+/**
+ * Open or close a batch of changes, so that listeners are notified once
+ * for all of the options assigned by a parse
+ *
+ * @tparam Options The type of \a options
+ *
+ * @param[in] options The options being assigned
+ * @param[in] step    Whether to open or close the batch
+ */
+template <typename Options>
+void CommandLine::Batch(void* options, BatchStep step) {
+    switch (step) {
+      case BatchStep::kBegin:
+        static_cast<Options*>(options)->BeginBatch(); break;
+      case BatchStep::kEnd:
+        static_cast<Options*>(options)->EndBatch();   break;
+      case BatchStep::kAbort:
+        static_cast<Options*>(options)->AbortBatch(); break;
+    }
+}
+
+/**
+ * Suggest completions of a command line argument
+ *
+ * @tparam Options The type of \a options
+ *
+ * @param[in]  options    The options being completed
+ * @param[in]  word       The argument being typed
+ * @param[out] candidates The complete arguments it could become
+ */
+template <typename Options>
+void CommandLine::Complete(const void* options,
+                           std::string_view word,
+                           std::vector<std::string>* candidates) {
+    static_cast<const Options*>(options)->Complete(word, candidates);
+}
+
+/**
+ * Get the profile attached to a set of options
+ *
+ * @tparam Options The type of \a options
+ *
+ * @param[in] options The options
+ *
+ * @return The profile, or null if none is attached
+ */
+template <typename Options>
+StartupProfile* CommandLine::Profile(const void* options) {
+    return static_cast<const Options*>(options)->Profile();
+}
+
+/**
+ * Stage the parsed values on top of the current ones and publish them, but
+ * only if every value was accepted
+ *
+ * @tparam Options The type of \a options
+ *
+ * @param[in]  options The options to which the values belong
+ * @param[in]  args    The option, value pairs
+ * @param[out] errors  The options that were rejected, and why
+ */
+template <typename Options>
+void CommandLine::Reload(void* options,
+                         const ParsedArgs& args,
+                         std::vector<OptionError>* errors) {
+    Options& target = *static_cast<Options*>(options);
+
+    auto snapshot = target.Stage();
+
+    for (const auto& pair : args) {
+        const CmdLineError error =
+            snapshot.SetFromString(pair.first, pair.second);
+
+        if (error != CmdLineError::kSuccess)
+            errors->push_back({std::string(pair.first), error});
+    }
+
+    if (errors->empty())
+        target.Publish(std::move(snapshot));
+}
+
+/**
+ * Assign an option from its string representation
+ *
+ * @tparam Options The type of \a options
+ *
+ * @param[in] options The options to which this option belongs
+ * @param[in] name    The option name
+ * @param[in] value   The string to convert
+ *
+ * @return A \ref CmdLineError return code
+ */
+template <typename Options>
+CmdLineError CommandLine::SetFromString(void* options,
+                                        std::string_view name,
+                                        std::string_view value) {
+    return static_cast<Options*>(options)->SetFromString(name, value);
+}
+
+/**
+ * Attach a profile to a set of options
+ *
+ * @tparam Options The type of \a options
+ *
+ * @param[in] options The options
+ * @param[in] profile The profile, or null to detach the current one
+ */
+template <typename Options>
+void CommandLine::SetProfile(void* options, StartupProfile* profile) {
+    static_cast<Options*>(options)->SetProfile(profile);
+}
+
+/**
+ * Default constructor. Allocates from the default memory resource
+ */
+template <typename Threading, typename... Ts>
+BasicUserOptions<Threading, Ts...>::BasicUserOptions()
+    : BasicUserOptions(std::pmr::get_default_resource()) {
+}
+
+/**
+ * Constructor
+ *
+ * @param[in] resource The memory resource to allocate from, which must
+ *                     outlive these options and any copy of them
+ */
+template <typename Threading, typename... Ts>
+BasicUserOptions<Threading, Ts...>::BasicUserOptions(
+    std::pmr::memory_resource* resource)
+    : options_(OptionSet<Ts>(resource)...),
+      strings_(resource),
+      index_(resource),
+      groups_(resource),
+      schema_slots_(resource) {
+}
+
+/**
+ * Constructor which profiles these options. They allocate from the profile,
+ * so that it counts their allocations as well as timing each phase
+ *
+ * @param[in] profile The profile, which must outlive these options and any
+ *                    copy of them
+ */
+template <typename Threading, typename... Ts>
+BasicUserOptions<Threading, Ts...>::BasicUserOptions(StartupProfile* profile)
+    : BasicUserOptions(static_cast<std::pmr::memory_resource*>(profile)) {
+    profile_ = profile;
+}
+
+/**
+ * Copy constructor. The copy allocates from the same memory resource
+ *
+ * @param[in] opts The options to copy
+ */
+template <typename Threading, typename... Ts>
+BasicUserOptions<Threading, Ts...>::BasicUserOptions(
+    const BasicUserOptions& opts)
+    : BasicUserOptions(opts.Resource()) {
+    *this = opts;
+}
+
+/**
+ * Copy assignment. The options and their values are copied, but not the
+ * listeners, dispatcher or open batches, which stay with each object
+ *
+ * @param[in] opts The options to copy
+ *
+ * @return *this
+ */
+template <typename Threading, typename... Ts>
+auto BasicUserOptions<Threading, Ts...>::operator=(
+    const BasicUserOptions& opts) -> BasicUserOptions& {
+    if (this == &opts)
+        return *this;
+
+    options_      = opts.options_;
+    strings_      = opts.strings_;
+    schema_       = opts.schema_;
+    schema_find_  = opts.schema_find_;
+    schema_slots_ = opts.schema_slots_;
+    generation_   = opts.generation_;
+    profile_      = opts.profile_;
+
+    if (!Resource()->is_equal(*opts.Resource())) {
+        Reintern(opts);
+        return *this;
+    }
+
+    index_    = opts.index_;
+    groups_   = opts.groups_;
+    snapshot_ = opts.snapshot_;
+    help_     = opts.help_;
+    names_    = opts.names_;
+
+    return *this;
+}
+
+/**
+ * Move assignment. Options that allocate from another memory resource are
+ * copied as by the copy assignment, since their storage cannot change
+ * hands. Either way, the listeners, dispatcher and open batches are taken
+ *
+ * @param[in] opts The options to take
+ *
+ * @return *this
+ */
+template <typename Threading, typename... Ts>
+auto BasicUserOptions<Threading, Ts...>::operator=(
+    BasicUserOptions&& opts) -> BasicUserOptions& {
+    if (this == &opts)
+        return *this;
+
+    if (Resource()->is_equal(*opts.Resource())) {
+        options_      = std::move(opts.options_);
+        strings_      = std::move(opts.strings_);
+        index_        = std::move(opts.index_);
+        groups_       = std::move(opts.groups_);
+        schema_       = std::move(opts.schema_);
+        schema_find_  = opts.schema_find_;
+        schema_slots_ = std::move(opts.schema_slots_);
+        generation_   = opts.generation_;
+        snapshot_     = opts.snapshot_;
+        help_         = opts.help_;
+        names_        = opts.names_;
+        profile_      = opts.profile_;
+    } else {
+        *this = static_cast<const BasicUserOptions&>(opts);
+    }
+
+    subscribers_ = std::move(opts.subscribers_);
+    next_id_     = opts.next_id_;
+    pending_     = std::move(opts.pending_);
+    batch_depth_ = opts.batch_depth_;
+    dispatcher_  = std::move(opts.dispatcher_);
+
+    return *this;
+}
+
+/**
+ * Rebuild everything that views the names and descriptions of options
+ * copied from another memory resource, whose strings have been copied into
+ * \ref strings_. The published snapshot is copied into this resource too
+ *
+ * @param[in] opts The options copied
+ */
+template <typename Threading, typename... Ts>
+void BasicUserOptions<Threading, Ts...>::Reintern(
+    const BasicUserOptions& opts) {
+    Reintern_<Ts...>();
+
+    index_.clear();
+    index_.reserve(opts.index_.size());
+
+    groups_ = internal::PrefixIndex(Resource());
+    groups_.Reserve(opts.index_.size());
+
+    // Interning a stored string returns its copy without growing
+
+    for (const auto& entry : opts.index_) {
+        const std::string_view key = strings_.Intern(entry.first);
+
+        index_.emplace(key, entry.second);
+        groups_.Insert(key);
+    }
+
+    std::shared_ptr<const Snapshot> snapshot = opts.snapshot_.Load();
+    if (snapshot) {
+        const std::pmr::polymorphic_allocator<Snapshot> allocator(
+            Resource());
+
+        snapshot = std::allocate_shared<Snapshot>(
+            allocator, Snapshot(*snapshot, Resource()));
+    }
+
+    snapshot_.Store(snapshot);
+    help_.Store(nullptr);
+    names_.Store(nullptr);
+}
+
+/**
+ * Compile-time recursive base case of this method
+ */
+template <typename Threading, typename... Ts>
+template <typename U>
+void BasicUserOptions<Threading, Ts...>::Reintern_() {
+    std::get<OptionSet<U>>(options_).Reintern(&strings_);
+}
+
+/**
+ * Point the names and descriptions of every option at their copies in
+ * \ref strings_
+ */
+template <typename Threading, typename... Ts>
+template <typename U1, typename U2, typename... Us>
+void BasicUserOptions<Threading, Ts...>::Reintern_() {
+    Reintern_<U1>();
+    Reintern_<U2, Us...>();
+}
+
+/**
+ * Add a new command line option which is settable via the command line
+ *
+ * @tparam T The type of the option
+ *
+ * @param[in] name          The name of the option to add
+ * @param[in] default_value The default value to assign the option
+ * @param[in] desc          A description for the option
+ *
+ * @return A \ref CmdLineError return code. If copying the default value
+ *         throws, the option is not added
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+CmdLineError BasicUserOptions<Threading, Ts...>::Add(const std::string& name,
+                                     const T& default_value,
+                                     const std::string& desc) {
+    StartupProfile::Timer timer(profile_, StartupProfile::Phase::kRegister);
+
+    if (internal::IsBlank(name)) return CmdLineError::kEmptyName;
+
+    OptionSet<T>& options = std::get<OptionSet<T>>(options_);
+
+    // Interning a duplicate name returns the stored copy without growing
+
+    const std::string_view key = strings_.Intern(name);
+
+    auto added = index_.emplace(key, Slot{ TypeIndex<T>(), 0 });
+    if (!added.second) return CmdLineError::kDuplicate;
+
+    // Forget the name again if the option cannot be stored
+
+    struct Forget {
+        decltype(index_)* index;
+        std::string_view  key;
+        ~Forget() { if (index != nullptr) index->erase(key); }
+    } forget{ &index_, key };
+
+    groups_.Reserve(1);
+
+    added.first->second.index =
+        options.Add(key, strings_.Intern(desc), default_value);
+    forget.index = nullptr;
+
+    // Room was made above, so this cannot throw
+
+    groups_.Insert(key);
+
+    help_.Store(nullptr);
+    names_.Store(nullptr);
+
+    return CmdLineError::kSuccess;
+}
+
+/**
+ * Add many options of the same type at once. This makes room for all of
+ * them up front, and adds none of them if any name is blank, already in
+ * use, or repeated. If copying a default value throws, the options before
+ * it remain added
+ *
+ * @tparam T        The type of the options
+ * @tparam Iterator A forward iterator to \ref Definition<T>
+ *
+ * @param[in] first The first option to add
+ * @param[in] last  One past the last option to add
+ *
+ * @return A \ref CmdLineError return code
+ */
+template <typename Threading, typename... Ts>
+template <typename T, typename Iterator>
+CmdLineError BasicUserOptions<Threading, Ts...>::AddAll(Iterator first,
+                                                        Iterator last) {
+    StartupProfile::Timer timer(profile_, StartupProfile::Phase::kRegister);
+
+    const auto count = static_cast<std::size_t>(std::distance(first, last));
+
+    OptionSet<T>& options = std::get<OptionSet<T>>(options_);
+
+    Reserve(count);
+    options.Reserve(count);
+
+    // Index every name before adding anything, so that it can be undone
+
+    std::pmr::vector<std::pair<std::string_view, Slot*>> keys(Resource());
+    keys.reserve(count);
+
+    // On leaving early, forget every name from the first not yet added
+
+    std::size_t i = 0;
+
+    struct Forget {
+        decltype(index_)*     index;
+        const decltype(keys)& names;
+        const std::size_t&    added;
+        ~Forget() {
+            if (index == nullptr) return;
+            for (std::size_t j = added; j < names.size(); j++)
+                index->erase(names[j].first);
+        }
+    } forget{ &index_, keys, i };
+
+    CmdLineError error = CmdLineError::kSuccess;
+
+    for (Iterator iter = first; iter != last; ++iter) {
+        const Definition<T>& definition = *iter;
+
+        if (internal::IsBlank(definition.name)) {
+            error = CmdLineError::kEmptyName; break;
+        }
+
+        const std::string_view key = strings_.Intern(definition.name);
+
+        auto added = index_.emplace(key, Slot{ TypeIndex<T>(), 0 });
+        if (!added.second) {
+            error = CmdLineError::kDuplicate; break;
+        }
+
+        keys.emplace_back(key, &added.first->second);
+    }
+
+    if (error != CmdLineError::kSuccess) return error;
+
+    // Discarded first, in case only some of the options are added
+
+    help_.Store(nullptr);
+    names_.Store(nullptr);
+
+    for (Iterator iter = first; iter != last; ++iter, ++i) {
+        const Definition<T>& definition = *iter;
+
+        keys[i].second->index =
+            options.Add(keys[i].first,
+                        strings_.Intern(definition.description),
+                        definition.default_value);
+        groups_.Insert(keys[i].first);
+    }
+
+    forget.index = nullptr;
+
+    return CmdLineError::kSuccess;
+}
+
+/**
+ * Add every option saved in a binary snapshot by \ref Save(). The file is
+ * mapped into memory, and names and descriptions are used in place rather
+ * than copied, so the mapping lasts as long as these options or any copy
+ * of them. This must be called before any option is added
+ *
+ * @param[in] path   The snapshot file
+ * @param[in] schema The fingerprint the snapshot was saved with
+ *
+ * @return A \ref CmdLineError return code. kInvalidConfig if the file is
+ *         missing or ill-formed, or was saved by an incompatible build or
+ *         with a different fingerprint
+ */
+template <typename Threading, typename... Ts>
+CmdLineError BasicUserOptions<Threading, Ts...>::Load(const std::string& path,
+                                                      std::uint64_t schema) {
+    StartupProfile::Timer timer(profile_, StartupProfile::Phase::kRegister);
+
+    auto file = std::allocate_shared<internal::MappedFile>(
+        std::pmr::polymorphic_allocator<internal::MappedFile>(Resource()));
+
+    if (!file->Open(path))
+        return CmdLineError::kInvalidConfig;
+
+    const std::string_view blob = file->Contents();
+
+    return Load_(blob, schema, std::shared_ptr<char[]>(
+        file, const_cast<char*>(blob.data())));
+}
+
+/**
+ * Hold change notifications until the matching \ref EndBatch(), so that
+ * each subscriber receives every change in the batch at once. Batches may
+ * be nested. A \ref Batch also closes the batch if an exception is thrown
+ */
+template <typename Threading, typename... Ts>
+void BasicUserOptions<Threading, Ts...>::BeginBatch() noexcept {
+    batch_depth_++;
+}
+
+/**
+ * Bind a handle to an option, which can then be used to read its value
+ * without looking it up by name
+ *
+ * @param[in]  name   The name of the option
+ * @param[out] handle A handle to this option
+ *
+ * @return A \ref CmdLineError return code
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+CmdLineError BasicUserOptions<Threading, Ts...>::Bind(const std::string& name,
+                                      OptionHandle<T>* handle) const {
+    if (internal::IsBlank(name))
+        return CmdLineError::kEmptyName;
+
+    CmdLineError error;
+    const std::size_t index = Find<T>(name, &error);
+
+    if (error != CmdLineError::kSuccess)
+        return error;
+
+    *handle = OptionHandle<T>(&std::get<OptionSet<T>>(options_), index);
+
+    return CmdLineError::kSuccess;
+}
+
+/**
+ * Get the most recently published snapshot. This never blocks, and the
+ * snapshot remains valid for as long as the caller holds it, even if a
+ * newer one is published meanwhile
+ *
+ * @return The snapshot, or nullptr if none has been published
+ */
+template <typename Threading, typename... Ts>
+auto BasicUserOptions<Threading, Ts...>::Current() const
+    -> std::shared_ptr<const Snapshot> {
+    return snapshot_.Load();
+}
+
+/**
+ * Get the default value of an option
+ * 
+ * @param[in]  name  The name of the option
+ * @param[out] value The default value of this option
+ * 
+ * @return A \ref CmdLineError return code
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+CmdLineError
+BasicUserOptions<Threading, Ts...>::Default(const std::string& name,
+                                            T* value) const {
+    if (internal::IsBlank(name))
+        return CmdLineError::kEmptyName;
+
+    CmdLineError error;
+    const std::size_t index = Find<T>(name, &error);
+
+    if (error != CmdLineError::kSuccess)
+        return error;
+
+    *value = std::get<OptionSet<T>>(options_).DefaultValue(index);
+
+    return CmdLineError::kSuccess;
+}
+
+/**
+ * Compile-time recursive base case of this method
+ */
+template <typename Threading, typename... Ts>
+template <typename U>
+void BasicUserOptions<Threading, Ts...>::Delete_(const Slot& slot) {
+    std::get<OptionSet<U>>(options_).Remove(slot.index);
+}
+
+/**
+ * Remove the option at the given location
+ *
+ * @param[in] slot The location of the option to remove
+ */
+template <typename Threading, typename... Ts>
+template <typename U1, typename U2, typename... Us>
+void BasicUserOptions<Threading, Ts...>::Delete_(const Slot& slot) {
+    if (slot.type == TypeIndex<U1>())
+        Delete_<U1>(slot);
+    else
+        Delete_<U2, Us...>(slot);
+}
+
+/**
+ * Delete an option
+ * 
+ * @param[in] name The name of the option to delete
+ * 
+ * @return A \ref CmdLineError return code
+ */
+template <typename Threading, typename... Ts>
+CmdLineError
+BasicUserOptions<Threading, Ts...>::Delete(const std::string& name) {
+    auto iter = index_.find(name);
+    if (iter == index_.end())
+        return CmdLineError::kDoesNotExist;
+
+    const Slot slot = iter->second;
+
+    // A later option of the same name is found through index_ instead
+
+    if (schema_ != nullptr) {
+        const std::size_t position = schema_find_(schema_.get(), name);
+        if (position < schema_slots_.size())
+            schema_slots_[position].type = sizeof...(Ts);
+    }
+
+    groups_.Erase(iter->first);
+    index_.erase(iter);
+
+    Delete_<Ts...>(slot);
+
+    help_.Store(nullptr);
+    names_.Store(nullptr);
+
+    return CmdLineError::kSuccess;
+}
+
+/**
+ * Close a batch opened by \ref BeginBatch(). Closing the outermost batch
+ * delivers the notifications held since it was opened
+ */
+template <typename Threading, typename... Ts>
+void BasicUserOptions<Threading, Ts...>::EndBatch() {
+    if (batch_depth_ > 0 && --batch_depth_ == 0 && !pending_.empty())
+        Dispatch();
+}
+
+/**
+ * Check for the existence of an option by name
+ * 
+ * @param[in] name The name of the option to search for
+ * 
+ * @return True if the option exists
+ */
+template <typename Threading, typename... Ts>
+bool BasicUserOptions<Threading, Ts...>::Exists(const std::string& name) const {
+    return Locate(name) != nullptr;
+}
+
+/**
+ * Get the current value of an option
+ * 
+ * @param[in]  name  The name of the option
+ * @param[out] value The current value of this option
+ * 
+ * @return A \ref CmdLineError return code
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+CmdLineError
+BasicUserOptions<Threading, Ts...>::Get(const std::string& name,
+                                        T* value) const {
+    if (internal::IsBlank(name))
+        return CmdLineError::kEmptyName;
+
+    CmdLineError error;
+    const std::size_t index = Find<T>(name, &error);
+
+    if (error != CmdLineError::kSuccess)
+        return error;
+
+    *value = std::get<OptionSet<T>>(options_).CurrentValue(index);
+
+    return CmdLineError::kSuccess;
+}
+
+/**
+ * Set the value of an option
+ * 
+ * @param[in]  name  The name of the option
+ * @param[out] value The value to assign this option
+ * 
+ * @return A \ref CmdLineError return code
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+CmdLineError
+BasicUserOptions<Threading, Ts...>::Set(const std::string& name,
+                                        const T& value) {
+    if (internal::IsBlank(name))
+        return CmdLineError::kEmptyName;
+
+    CmdLineError error;
+    const std::size_t index = Find<T>(name, &error);
+
+    if (error != CmdLineError::kSuccess)
+        return error;
+
+    OptionSet<T>& options = std::get<OptionSet<T>>(options_);
+
+    if (options.Assign(index, value))
+        Notify(options.Name(index));
+
+    return CmdLineError::kSuccess;
+}
+
+/**
+ * Set many options of the same type at once. Listeners are notified once
+ * for all of them. If any option does not exist or has a different type,
+ * none are set
+ *
+ * @tparam T        The type of the options
+ * @tparam Iterator A forward iterator to pairs whose first member is the
+ *                  option name and whose second is its value
+ *
+ * @param[in] first The first name, value pair
+ * @param[in] last  One past the last name, value pair
+ *
+ * @return A \ref CmdLineError return code
+ */
+template <typename Threading, typename... Ts>
+template <typename T, typename Iterator>
+CmdLineError BasicUserOptions<Threading, Ts...>::SetAll(Iterator first,
+                                                        Iterator last) {
+    std::pmr::vector<std::size_t> indices(Resource());
+    indices.reserve(static_cast<std::size_t>(std::distance(first, last)));
+
+    for (Iterator iter = first; iter != last; ++iter) {
+        const std::string_view name = iter->first;
+
+        if (internal::IsBlank(name))
+            return CmdLineError::kEmptyName;
+
+        CmdLineError error;
+        indices.push_back(Find<T>(name, &error));
+
+        if (error != CmdLineError::kSuccess)
+            return error;
+    }
+
+    OptionSet<T>& options = std::get<OptionSet<T>>(options_);
+
+    {
+        Batch batch(this);
+
+        std::size_t i = 0;
+        for (Iterator iter = first; iter != last; ++iter, ++i) {
+            if (options.Assign(indices[i], iter->second))
+                Notify(options.Name(indices[i]));
+        }
+    }
+
+    return CmdLineError::kSuccess;
+}
+
+/**
+ * Choose the thread on which change notifications are delivered. Each
+ * notification is passed to \a dispatcher as a task, which it may run
+ * immediately or hand to another thread, e.g. via a queue
+ *
+ * @param[in] dispatcher Runs notification tasks. If empty, listeners are
+ *                       invoked directly by the thread making the change
+ */
+template <typename Threading, typename... Ts>
+void BasicUserOptions<Threading, Ts...>::SetDispatcher(Dispatcher dispatcher) {
+    dispatcher_ = std::move(dispatcher);
+}
+
+/**
+ * Set the value of an option from its string representation, converting
+ * it to the option's type
+ *
+ * @param[in] name  The name of the option
+ * @param[in] value The string to convert
+ *
+ * @return A \ref CmdLineError return code
+ */
+template <typename Threading, typename... Ts>
+CmdLineError
+BasicUserOptions<Threading, Ts...>::SetFromString(std::string_view name,
+                                                  std::string_view value) {
+    StartupProfile::Timer resolving(profile_,
+                                    StartupProfile::Phase::kResolve);
+
+    if (internal::IsBlank(name))
+        return CmdLineError::kEmptyName;
+
+    const Slot* slot = Locate(name);
+    if (slot == nullptr)
+        return CmdLineError::kDoesNotExist;
+
+    resolving.Stop();
+
+    return SetFromString_<Ts...>(*slot, value);
+}
+
+/**
+ * Attach a profile, which times each phase of startup from now on. To also
+ * count allocations, construct the options on the profile instead
+ *
+ * @param[in] profile The profile, or null to stop profiling. It must
+ *                    outlive these options, or be detached first
+ */
+template <typename Threading, typename... Ts>
+void BasicUserOptions<Threading, Ts...>::SetProfile(
+    StartupProfile* profile) noexcept {
+    profile_ = profile;
+}
+
+/**
+ * Print the command line options for the program, sorted by name, one per
+ * line with their descriptions aligned in a column. The sorted options are
+ * cached, so printing a few of them from a large table is cheap. Building
+ * that cache modifies the options, so with the \ref SingleThreaded policy
+ * this must not be called by two threads at once, even though it is const
+ *
+ * @param[in] prog_name Usually the 1st command line argument, which
+ *                      is the executable name
+ * @param[in] os        The output stream object to write to
+ * @param[in] prefix    Print only the options whose names begin with this,
+ *                      e.g. "net." for those in the net group. Empty for
+ *                      all options
+ */
+template <typename Threading, typename... Ts>
+void BasicUserOptions<Threading, Ts...>::Print(const char* prog_name,
+                                               std::ostream& os,
+                                               std::string_view prefix)
+    const {
+    /*
+     * Usage wider than this pushes the description onto the next line,
+     * rather than pushing every description far to the right
+     */
+    constexpr std::size_t kMaxUsage = 40;
+
+    /*
+     * A full listing comes from the cached, sorted list. A partial one is
+     * built from the names under the prefix, which avoids sorting every
+     * option to print just a few of them
+     */
+    std::shared_ptr<const HelpIndex> help;
+
+    if (prefix.empty()) {
+        help = Help();
+    } else {
+        std::pmr::vector<std::string_view> names(Resource());
+        groups_.Collect(prefix, &names);
+
+        auto partial = std::make_shared<HelpIndex>(Resource());
+        partial->reserve(names.size());
+
+        for (std::string_view name : names)
+            partial->push_back(Describe_<Ts...>(index_.find(name)->second));
+
+        help = std::move(partial);
+    }
+
+    const auto first = help->begin();
+    const auto last  = help->end();
+
+    auto usage = [](const OptionInfo& option) {
+        return option.name.size() + std::strlen(option.type) +
+               option.default_value.size() + 10;
+    };
+
+    std::size_t width = 0;
+    std::size_t total = 0;
+
+    for (auto iter = first; iter != last; ++iter) {
+        const std::size_t size = usage(*iter);
+
+        if (size <= kMaxUsage) width = std::max(width, size);
+        total += size + iter->description.size() + kMaxUsage + 4;
+    }
+
+    const std::size_t column = std::max<std::size_t>(width, 4) + 2;
+
+    std::string output;
+    output.reserve(total + 64);
+
+    output.append("usage: ").append(prog_name).append(" [options]\n")
+          .append("options:\n\n");
+
+    for (auto iter = first; iter != last; ++iter) {
+        const std::size_t size = usage(*iter);
+
+        output.append("  --").append(iter->name)
+              .append("=<").append(iter->type)
+              .append("> [").append(iter->default_value).append("]");
+
+        if (!iter->description.empty()) {
+            if (size > width)
+                output.append("\n").append(column, ' ');
+            else
+                output.append(column - size, ' ');
+
+            output.append(iter->description);
+        }
+
+        output.push_back('\n');
+    }
+
+    os.write(output.data(), static_cast<std::streamsize>(output.size()));
+}
+
+/**
+ * Get the current value of every option in a group, as strings. A group is
+ * a dotted prefix, as for \ref SubscribeGroup()
+ *
+ * @param[in]  group  The group name, or empty for every option
+ * @param[out] values The name and value of each option in the group,
+ *                    sorted by name
+ *
+ * @return A \ref CmdLineError return code
+ */
+template <typename Threading, typename... Ts>
+CmdLineError BasicUserOptions<Threading, Ts...>::GetGroup(
+    const std::string& group,
+    std::vector<std::pair<std::string, std::string>>* values) const {
+    std::pmr::vector<std::string_view> names(Resource());
+    groups_.Collect(GroupPrefix(group), &names);
+
+    if (names.empty())
+        return CmdLineError::kDoesNotExist;
+
+    values->clear();
+    values->reserve(names.size());
+
+    for (std::string_view name : names) {
+        values->emplace_back(std::string(name),
+                             ToString_<Ts...>(index_.find(name)->second));
+    }
+
+    return CmdLineError::kSuccess;
+}
+
+/**
+ * Get the name of every option beginning with a prefix
+ *
+ * @param[in] prefix The prefix, or empty for every option
+ *
+ * @return The names, sorted
+ */
+template <typename Threading, typename... Ts>
+std::vector<std::string> BasicUserOptions<Threading, Ts...>::Names(
+    std::string_view prefix) const {
+    std::pmr::vector<std::string_view> names(Resource());
+    groups_.Collect(prefix, &names);
+
+    return std::vector<std::string>(names.begin(), names.end());
+}
+
+/**
+ * Publish a snapshot of the current option values
+ */
+template <typename Threading, typename... Ts>
+void BasicUserOptions<Threading, Ts...>::Publish() {
+    Commit(Stage());
+}
+
+/**
+ * Apply a staged set of values and publish them as a whole. The values are
+ * first assigned to the options themselves, after which the snapshot is
+ * swapped in for readers of \ref Current(). Only those readers see the
+ * values change all at once; readers of \ref Get() and of option handles
+ * may see some of the new values before others. Options must not be added
+ * or deleted between staging and publishing
+ *
+ * @param[in] snapshot A snapshot obtained from \ref Stage()
+ */
+template <typename Threading, typename... Ts>
+void BasicUserOptions<Threading, Ts...>::Publish(Snapshot&& snapshot) {
+    Batch batch(this);
+
+    Publish_<Ts...>(snapshot);
+    Commit(std::move(snapshot));
+}
+
+/**
+ * Make room for more options, so that adding them one at a time does not
+ * resize the name index
+ *
+ * @param[in] count The number of options that will be added
+ */
+template <typename Threading, typename... Ts>
+void BasicUserOptions<Threading, Ts...>::Reserve(std::size_t count) {
+    const std::size_t size = index_.size() + count;
+
+    if (size > index_.bucket_count() * index_.max_load_factor())
+        index_.reserve(std::max(size, 2 * index_.size()));
+
+    strings_.Reserve(count);
+    groups_.Reserve(count);
+}
+
+/**
+ * Return every option in a group to its default value. A group is a dotted
+ * prefix, as for \ref SubscribeGroup(). Listeners are notified once for
+ * the whole group
+ *
+ * @param[in] group The group name, or empty for every option
+ *
+ * @return A \ref CmdLineError return code
+ */
+template <typename Threading, typename... Ts>
+CmdLineError
+BasicUserOptions<Threading, Ts...>::ResetGroup(const std::string& group) {
+    std::pmr::vector<std::string_view> names(Resource());
+    groups_.Collect(GroupPrefix(group), &names);
+
+    if (names.empty())
+        return CmdLineError::kDoesNotExist;
+
+    {
+        Batch batch(this);
+
+        for (std::string_view name : names)
+            Reset_<Ts...>(index_.find(name)->second);
+    }
+
+    return CmdLineError::kSuccess;
+}
+
+/**
+ * Suggest completions for a partly typed command line argument, for use by
+ * shell completion. An argument "--na" completes to the options whose
+ * names begin with "na", followed by '=' unless they are bool, and an
+ * argument "--name=v" completes to the values of option "name" beginning
+ * with "v": true and false for a bool, and the default for other types
+ *
+ * @param[in]  word       The argument being typed
+ * @param[out] candidates The complete arguments it could become, sorted
+ */
+template <typename Threading, typename... Ts>
+void BasicUserOptions<Threading, Ts...>::Complete(
+    std::string_view word, std::vector<std::string>* candidates) const {
+    candidates->clear();
+
+    if (word.size() < 2) {
+        if (word != std::string_view("--").substr(0, word.size())) return;
+        word = std::string_view();
+    } else if (word.compare(0, 2, "--") == 0) {
+        word.remove_prefix(2);
+    } else {
+        return;
+    }
+
+    const std::size_t equal = word.find('=');
+
+    if (equal != std::string_view::npos) {
+        auto iter = index_.find(word.substr(0, equal));
+        if (iter != index_.end()) {
+            Complete_<Ts...>(iter->second, word.substr(equal + 1),
+                             candidates);
+        }
+
+        return;
+    }
+
+    std::pmr::vector<std::string_view> names(Resource());
+    groups_.Collect(word, &names);
+
+    candidates->reserve(names.size());
+
+    for (std::string_view name : names) {
+        std::string candidate;
+        candidate.reserve(name.size() + 3);
+        candidate.append("--").append(name);
+
+        if (index_.find(name)->second.type != TypeIndex_<bool, Ts...>())
+            candidate.push_back('=');
+
+        candidates->push_back(std::move(candidate));
+    }
+}
+
+/**
+ * Add every option saved in a binary snapshot by \ref Save(), copying
+ * names and descriptions. This must be called before any option is added
+ *
+ * @param[in] blob   The snapshot
+ * @param[in] schema The fingerprint the snapshot was saved with
+ *
+ * @return A \ref CmdLineError return code, as for \ref Load()
+ */
+template <typename Threading, typename... Ts>
+CmdLineError
+BasicUserOptions<Threading, Ts...>::Restore(std::string_view blob,
+                                            std::uint64_t schema) {
+    return Load_(blob, schema, nullptr);
+}
+
+/**
+ * Get the memory resource from which these options allocate
+ *
+ * @return The memory resource
+ */
+template <typename Threading, typename... Ts>
+std::pmr::memory_resource*
+BasicUserOptions<Threading, Ts...>::Resource() const noexcept {
+    return index_.get_allocator().resource();
+}
+
+/**
+ * Get the profile attached to these options
+ *
+ * @return The profile, or null if none is attached
+ */
+template <typename Threading, typename... Ts>
+StartupProfile*
+BasicUserOptions<Threading, Ts...>::Profile() const noexcept {
+    return profile_;
+}
+
+/**
+ * Write every option, with its type, default and current value, to a
+ * binary snapshot. A process with the same supported types can read it
+ * back via \ref Load() far faster than adding and setting each option
+ *
+ * @param[in] os     The stream to write to
+ * @param[in] schema A fingerprint of how the options were declared, such
+ *                   as Schema::Fingerprint(), for \ref Load() to check
+ *
+ * @return A \ref CmdLineError return code. kOutOfRange if the strings
+ *         exceed 4 GiB
+ */
+template <typename Threading, typename... Ts>
+CmdLineError BasicUserOptions<Threading, Ts...>::Save(std::ostream& os,
+                                                      std::uint64_t schema)
+    const {
+    std::string blob(sizeof(internal::BlobHeader), '\0');
+    std::string pool;
+
+    if (!Save_<Ts...>(&blob, &pool))
+        return CmdLineError::kOutOfRange;
+
+    internal::BlobHeader header;
+    std::memcpy(header.magic, internal::kBlobMagic, sizeof(header.magic));
+    header.version    = internal::kBlobVersion;
+    header.byte_order = internal::kBlobByteOrder;
+    header.types      = TypesHash();
+    header.schema     = schema;
+    header.pool       = blob.size();
+    header.pool_size  = pool.size();
+
+    std::memcpy(&blob[0], &header, sizeof(header));
+    blob += pool;
+
+    os.write(blob.data(), static_cast<std::streamsize>(blob.size()));
+
+    return os ? CmdLineError::kSuccess : CmdLineError::kInvalidConfig;
+}
+
+/**
+ * Copy the current option values into a new snapshot, which may be
+ * modified and then published. This leaves the option values untouched,
+ * so it may be done away from the threads reading them. The first call
+ * after an option is added or deleted caches the option names, so with the
+ * \ref SingleThreaded policy two threads must not stage at once
+ *
+ * @return The snapshot
+ */
+template <typename Threading, typename... Ts>
+auto BasicUserOptions<Threading, Ts...>::Stage() const -> Snapshot {
+    Snapshot snapshot(this);
+    Stage_<Ts...>(&snapshot);
+
+    return snapshot;
+}
+
+/**
+ * Register a listener for changes to an option. Listeners are invoked once
+ * per change outside of a batch, or once per batch otherwise. They must not
+ * subscribe or unsubscribe
+ *
+ * @param[in]  name     The name of the option
+ * @param[in]  listener Invoked with the names of the changed options
+ * @param[out] id       If not null, identifies this subscription for
+ *                      \ref Unsubscribe()
+ *
+ * @return A \ref CmdLineError return code
+ */
+template <typename Threading, typename... Ts>
+CmdLineError BasicUserOptions<Threading, Ts...>::Subscribe(
+    const std::string& name, Listener listener, std::size_t* id) {
+    if (internal::IsBlank(name))
         return CmdLineError::kEmptyName;
 
-    if (!Exists(name))
-        return CmdLineError::kDoesNotExist;
+    if (!Exists(name))
+        return CmdLineError::kDoesNotExist;
+
+    subscribers_.push_back({next_id_, name, false, std::move(listener)});
+
+    if (id != nullptr)
+        *id = next_id_;
+
+    next_id_++;
+
+    return CmdLineError::kSuccess;
+}
+
+/**
+ * Register a listener for changes to a group of options. A group is a
+ * dotted prefix, as produced by config file sections, so the group "net"
+ * covers "net.port" and "net.tls.cert" but not "network". The empty group
+ * covers every option, including those added later
+ *
+ * @param[in] group    The group name
+ * @param[in] listener Invoked with the names of the changed options
+ *
+ * @return An ID for this subscription, for \ref Unsubscribe()
+ */
+template <typename Threading, typename... Ts>
+std::size_t BasicUserOptions<Threading, Ts...>::SubscribeGroup(
+    const std::string& group, Listener listener) {
+    subscribers_.push_back({next_id_, GroupPrefix(group), true,
+                            std::move(listener)});
+
+    return next_id_++;
+}
+
+/**
+ * Remove a listener
+ *
+ * @param[in] id The ID of the subscription
+ *
+ * @return A \ref CmdLineError return code
+ */
+template <typename Threading, typename... Ts>
+CmdLineError BasicUserOptions<Threading, Ts...>::Unsubscribe(std::size_t id) {
+    auto iter = std::find_if(subscribers_.begin(), subscribers_.end(),
+        [id](const Subscriber& subscriber) { return subscriber.id == id; });
+
+    if (iter == subscribers_.end())
+        return CmdLineError::kDoesNotExist;
+
+    subscribers_.erase(iter);
+
+    return CmdLineError::kSuccess;
+}
+
+/**
+ * Compile-time recursive base case of this function
+ * 
+ * @return false
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+constexpr bool BasicUserOptions<Threading, Ts...>::IsSupported_() noexcept {
+    return false;
+}
+
+/**
+ * Check if a type is supported by this library
+ * 
+ * @return True if supported
+ */
+template <typename Threading, typename... Ts>
+template <typename T, typename U, typename... Us>
+constexpr bool BasicUserOptions<Threading, Ts...>::IsSupported_() noexcept {
+    return std::is_same<T,U>::value || IsSupported_<T, Us...>();
+}
+
+/**
+ * Check if the given type is supported by this library, i.e. it may be used
+ * as a command line option
+ * 
+ * @tparam T The type to check
+ * 
+ * @return True if this type is supported
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+constexpr bool BasicUserOptions<Threading, Ts...>::IsSupported() noexcept {
+    return IsSupported_<T, Ts...>();
+}
+
+/**
+ * Compile-time recursive base case of this method
+ */
+template <typename Threading, typename... Ts>
+template <typename U>
+CmdLineError
+BasicUserOptions<Threading, Ts...>::SetFromString_(const Slot& slot,
+                                                   std::string_view value) {
+    StartupProfile::Timer converting(profile_,
+                                     StartupProfile::Phase::kConvert);
+
+    U converted;
+    const CmdLineError error = internal::FromString(value, &converted);
+
+    converting.Stop();
+
+    StartupProfile::Timer assigning(profile_, StartupProfile::Phase::kAssign);
+
+    auto& options = std::get<OptionSet<U>>(options_);
+
+    if (error == CmdLineError::kSuccess &&
+        options.Assign(slot.index, converted)) {
+        Notify(options.Name(slot.index));
+    }
+
+    return error;
+}
+
+/**
+ * Convert and assign the value of the option at the given location
+ *
+ * @param[in] slot  The location of the option
+ * @param[in] value The string to convert
+ *
+ * @return A \ref CmdLineError return code
+ */
+template <typename Threading, typename... Ts>
+template <typename U1, typename U2, typename... Us>
+CmdLineError
+BasicUserOptions<Threading, Ts...>::SetFromString_(const Slot& slot,
+                                                   std::string_view value) {
+    if (slot.type == TypeIndex<U1>())
+        return SetFromString_<U1>(slot, value);
+
+    return SetFromString_<U2, Us...>(slot, value);
+}
+
+/**
+ * Get the prefix shared by the names of the options in a group
+ *
+ * @param[in] group The group name
+ *
+ * @return The group name followed by a '.', or empty for the empty group
+ */
+template <typename Threading, typename... Ts>
+std::string
+BasicUserOptions<Threading, Ts...>::GroupPrefix(std::string_view group) {
+    std::string prefix(internal::Trim(group));
+    if (!prefix.empty())
+        prefix.push_back('.');
+
+    return prefix;
+}
+
+/**
+ * Compile-time recursive base case of this method
+ */
+template <typename Threading, typename... Ts>
+template <typename U>
+void BasicUserOptions<Threading, Ts...>::Complete_(
+    const Slot& slot,
+    std::string_view value,
+    std::vector<std::string>* candidates) const {
+    const auto& options = std::get<OptionSet<U>>(options_);
+
+    std::string prefix("--");
+    prefix.append(options.Name(slot.index)).push_back('=');
+
+    auto suggest = [&](std::string_view candidate) {
+        if (!candidate.empty() &&
+            candidate.compare(0, value.size(), value) == 0) {
+            candidates->push_back(prefix + std::string(candidate));
+        }
+    };
+
+    if constexpr (std::is_same<U, bool>::value) {
+        suggest("false");
+        suggest("true");
+    } else {
+        suggest(internal::ToString(options.DefaultValue(slot.index)));
+    }
+}
+
+/**
+ * Suggest values for the option at the given location
+ *
+ * @param[in]  slot       The location of the option
+ * @param[in]  value      The part of the value typed so far
+ * @param[out] candidates The suggested arguments are appended to this
+ */
+template <typename Threading, typename... Ts>
+template <typename U1, typename U2, typename... Us>
+void BasicUserOptions<Threading, Ts...>::Complete_(
+    const Slot& slot,
+    std::string_view value,
+    std::vector<std::string>* candidates) const {
+    if (slot.type == TypeIndex<U1>())
+        return Complete_<U1>(slot, value, candidates);
+
+    Complete_<U2, Us...>(slot, value, candidates);
+}
+
+/**
+ * Compile-time recursive base case of this method
+ */
+template <typename Threading, typename... Ts>
+template <typename U>
+void BasicUserOptions<Threading, Ts...>::Reset_(const Slot& slot) {
+    auto& options = std::get<OptionSet<U>>(options_);
+
+    if (options.Assign(slot.index, options.DefaultValue(slot.index)))
+        Notify(options.Name(slot.index));
+}
+
+/**
+ * Return the option at the given location to its default value
+ *
+ * @param[in] slot The location of the option
+ */
+template <typename Threading, typename... Ts>
+template <typename U1, typename U2, typename... Us>
+void BasicUserOptions<Threading, Ts...>::Reset_(const Slot& slot) {
+    if (slot.type == TypeIndex<U1>())
+        return Reset_<U1>(slot);
+
+    Reset_<U2, Us...>(slot);
+}
+
+/**
+ * Compile-time recursive base case of this method
+ */
+template <typename Threading, typename... Ts>
+template <typename U>
+std::string
+BasicUserOptions<Threading, Ts...>::ToString_(const Slot& slot) const {
+    return internal::ToString(
+        std::get<OptionSet<U>>(options_).CurrentValue(slot.index));
+}
+
+/**
+ * Get the current value of the option at the given location as a string
+ *
+ * @param[in] slot The location of the option
+ *
+ * @return The value
+ */
+template <typename Threading, typename... Ts>
+template <typename U1, typename U2, typename... Us>
+std::string
+BasicUserOptions<Threading, Ts...>::ToString_(const Slot& slot) const {
+    if (slot.type == TypeIndex<U1>())
+        return ToString_<U1>(slot);
+
+    return ToString_<U2, Us...>(slot);
+}
+
+/**
+ * Swap in a new snapshot for readers of \ref Current(). The previous one
+ * is freed once its last reader lets go of it
+ *
+ * @param[in] snapshot The snapshot to publish
+ */
+template <typename Threading, typename... Ts>
+void BasicUserOptions<Threading, Ts...>::Commit(Snapshot&& snapshot) {
+    snapshot.generation_ = ++generation_;
+
+    const std::pmr::polymorphic_allocator<Snapshot> allocator(Resource());
+
+    snapshot_.Store(std::allocate_shared<Snapshot>(allocator,
+                                                   std::move(snapshot)));
+}
+
+/**
+ * Close a batch that is being left by an exception. Closing the outermost
+ * batch drops the notifications held since it was opened, since listeners
+ * must not be called while an exception is in flight
+ */
+template <typename Threading, typename... Ts>
+void BasicUserOptions<Threading, Ts...>::AbortBatch() noexcept {
+    if (batch_depth_ > 0 && --batch_depth_ == 0)
+        pending_.clear();
+}
+
+/**
+ * Deliver the pending changes, giving each subscriber a single call with
+ * every change it is interested in. Changes made by listeners invoked
+ * directly are delivered in a further round. If a listener throws, the
+ * changes not yet delivered are dropped
+ */
+template <typename Threading, typename... Ts>
+void BasicUserOptions<Threading, Ts...>::Dispatch() {
+    StartupProfile::Timer assigning(profile_, StartupProfile::Phase::kAssign);
+
+    std::vector<std::string> changed;
+
+    Batch batch(this);
+
+    while (!pending_.empty()) {
+        changed.clear();
+        changed.swap(pending_);
+
+        std::sort(changed.begin(), changed.end());
+        changed.erase(std::unique(changed.begin(), changed.end()),
+                      changed.end());
+
+        for (std::size_t i = 0; i < subscribers_.size(); i++) {
+            const Subscriber& subscriber = subscribers_[i];
+
+            /*
+             * Names sharing a prefix are adjacent once sorted, so a group
+             * is a contiguous range
+             */
+            auto first = std::lower_bound(changed.begin(), changed.end(),
+                                          subscriber.name);
+            auto last = first;
+
+            if (subscriber.group) {
+                while (last != changed.end() &&
+                       last->compare(0, subscriber.name.size(),
+                                     subscriber.name) == 0) {
+                    ++last;
+                }
+            } else if (last != changed.end() && *last == subscriber.name) {
+                ++last;
+            }
+
+            if (first == last)
+                continue;
+
+            std::vector<std::string> names(first, last);
+
+            if (dispatcher_) {
+                dispatcher_([listener = subscriber.listener,
+                             names = std::move(names)]() {
+                    listener(names);
+                });
+            } else {
+                subscriber.listener(names);
+            }
+        }
+    }
+}
+
+/**
+ * Record that an option changed, delivering the change right away unless
+ * a batch is open
+ *
+ * @param[in] name The name of the option
+ */
+template <typename Threading, typename... Ts>
+void BasicUserOptions<Threading, Ts...>::Notify(std::string_view name) {
+    if (subscribers_.empty())
+        return;
+
+    pending_.emplace_back(name);
+
+    if (batch_depth_ == 0)
+        Dispatch();
+}
+
+/**
+ * Compile-time recursive base case of this method
+ */
+template <typename Threading, typename... Ts>
+template <typename U>
+void BasicUserOptions<Threading, Ts...>::Publish_(const Snapshot& snapshot) {
+    auto& options = std::get<OptionSet<U>>(options_);
+    const auto& values = std::get<std::pmr::vector<U>>(snapshot.values_);
+
+    const std::size_t size = std::min(options.Slots(), values.size());
+
+    // Skip options deleted since staging, and any added in their slots
+
+    for (std::size_t i = 0; i < size; i++) {
+        if (!options.Live(i) ||
+            !snapshot.template Staged<U>(i, options.Version(i)))
+            continue;
+
+        if (options.Assign(i, values[i]))
+            Notify(options.Name(i));
+    }
+}
+
+/**
+ * Assign every option its value from a snapshot
+ *
+ * @param[in] snapshot The snapshot to apply
+ */
+template <typename Threading, typename... Ts>
+template <typename U1, typename U2, typename... Us>
+void BasicUserOptions<Threading, Ts...>::Publish_(const Snapshot& snapshot) {
+    Publish_<U1>(snapshot);
+    Publish_<U2, Us...>(snapshot);
+}
+
+/**
+ * Compile-time recursive base case of this method
+ */
+template <typename Threading, typename... Ts>
+template <typename U>
+void BasicUserOptions<Threading, Ts...>::Stage_(Snapshot* snapshot) const {
+    const auto& options = std::get<OptionSet<U>>(options_);
+    auto& values = std::get<std::pmr::vector<U>>(snapshot->values_);
+    auto& versions = std::get<TypeIndex<U>()>(snapshot->versions_);
+
+    values.reserve(options.Slots());
+    versions.reserve(options.Slots());
+
+    for (std::size_t i = 0; i < options.Slots(); i++) {
+        values.push_back(options.CurrentValue(i));
+        versions.push_back(options.Version(i));
+    }
+}
+
+/**
+ * Copy the current value of every option into a snapshot
+ *
+ * @param[out] snapshot The snapshot to fill
+ */
+template <typename Threading, typename... Ts>
+template <typename U1, typename U2, typename... Us>
+void BasicUserOptions<Threading, Ts...>::Stage_(Snapshot* snapshot) const {
+    Stage_<U1>(snapshot);
+    Stage_<U2, Us...>(snapshot);
+}
+
+/**
+ * Add the options from a binary snapshot
+ *
+ * @param[in] blob   The snapshot
+ * @param[in] schema The fingerprint the snapshot must have been saved with
+ * @param[in] block  The memory holding \a blob, to keep its strings in
+ *                   place, or nullptr to copy them
+ *
+ * @return A \ref CmdLineError return code
+ */
+template <typename Threading, typename... Ts>
+CmdLineError BasicUserOptions<Threading, Ts...>::Load_(
+    std::string_view blob, std::uint64_t schema,
+    std::shared_ptr<char[]> block) {
+    StartupProfile::Timer timer(profile_, StartupProfile::Phase::kRegister);
+
+    if (!index_.empty())
+        return CmdLineError::kDuplicate;
+
+    internal::BlobHeader header;
+    internal::BlobReader reader(blob);
+
+    if (!reader.Read(&header) ||
+        std::memcmp(header.magic, internal::kBlobMagic,
+                    sizeof(header.magic)) != 0 ||
+        header.version    != internal::kBlobVersion   ||
+        header.byte_order != internal::kBlobByteOrder ||
+        header.types      != TypesHash() ||
+        header.schema     != schema ||
+        header.pool < sizeof(header) || header.pool > blob.size() ||
+        header.pool_size != blob.size() - header.pool) {
+        return CmdLineError::kInvalidConfig;
+    }
+
+    const std::string_view pool = blob.substr(header.pool);
+    reader = internal::BlobReader(
+        blob.substr(sizeof(header), header.pool - sizeof(header)));
+
+    /*
+     * Check the whole snapshot before changing anything, so that a damaged
+     * one leaves no options, slots or adopted memory behind
+     */
+    {
+        std::pmr::vector<std::string_view> names(Resource());
+        internal::BlobReader checker = reader;
+
+        const CmdLineError error = Load_<Ts...>(&checker, pool, false, &names);
+
+        if (error != CmdLineError::kSuccess)
+            return error;
+
+        // The set is discarded whole, so its nodes need not be freed
+
+        std::pmr::monotonic_buffer_resource arena(Resource());
+        std::pmr::unordered_set<std::string_view> unique(names.size(),
+                                                         &arena);
+
+        for (std::string_view name : names) {
+            if (!unique.insert(name).second)
+                return CmdLineError::kInvalidConfig;
+        }
+    }
+
+    const bool stored = block != nullptr;
+    if (stored)
+        strings_.Adopt(std::move(block));
+
+    const CmdLineError error = Load_<Ts...>(&reader, pool, stored, nullptr);
+
+    help_.Store(nullptr);
+    names_.Store(nullptr);
+
+    return error;
+}
+
+/**
+ * Compile-time recursive base case of this method
+ */
+template <typename Threading, typename... Ts>
+template <typename U>
+CmdLineError BasicUserOptions<Threading, Ts...>::Load_(
+    internal::BlobReader* reader, std::string_view pool, bool stored,
+    std::pmr::vector<std::string_view>* checked) {
+    using Stored = typename internal::BlobValue<U>::type;
+
+    std::uint64_t count;
+    if (!reader->Read(&count) ||
+        count > reader->Remaining() / (sizeof(internal::BlobEntry) +
+                                       2 * sizeof(Stored))) {
+        return CmdLineError::kInvalidConfig;
+    }
+
+    const auto size = static_cast<std::size_t>(count);
+
+    OptionSet<U>& options = std::get<OptionSet<U>>(options_);
+
+    if (checked == nullptr) {
+        Reserve(size);
+        options.Reserve(size);
+    } else {
+        internal::ReserveMore(size, checked);
+    }
+
+    // Read the entries, defaults and current values side by side
+
+    internal::BlobReader entries = *reader;
+    reader->Skip(size * sizeof(internal::BlobEntry));
+
+    internal::BlobReader defaults = *reader;
+    reader->Skip(size * sizeof(Stored));
+
+    internal::BlobReader values = *reader;
+    reader->Skip(size * sizeof(Stored));
+
+    for (std::size_t i = 0; i < size; i++) {
+        internal::BlobEntry entry;
+        std::string_view name, description;
+        U default_value, value;
+
+        if (!entries.Read(&entry) ||
+            !internal::PoolString(pool, entry.name, &name) ||
+            !internal::PoolString(pool, entry.description, &description) ||
+            !internal::ReadValue(&defaults, pool, &default_value) ||
+            !internal::ReadValue(&values, pool, &value) ||
+            internal::IsBlank(name)) {
+            return CmdLineError::kInvalidConfig;
+        }
+
+        if (checked != nullptr) {
+            checked->push_back(name);
+            continue;
+        }
+
+        const std::string_view key = stored ?
+            strings_.InternStored(name) : strings_.Intern(name);
+
+        auto added = index_.emplace(key, Slot{ TypeIndex<U>(), 0 });
+        if (!added.second)
+            return CmdLineError::kInvalidConfig;
+
+        const std::size_t index = options.Add(
+            key,
+            stored ? strings_.InternStored(description)
+                   : strings_.Intern(description),
+            default_value);
+
+        added.first->second.index = index;
+        options.Assign(index, value);
+
+        groups_.Insert(key);
+    }
+
+    return CmdLineError::kSuccess;
+}
+
+/**
+ * Add the options of each type from a binary snapshot
+ *
+ * @param[in,out] reader  The snapshot, positioned after the header
+ * @param[in]     pool    The snapshot's string pool
+ * @param[in]     stored  True if the pool lives in this object's arena
+ * @param[in,out] checked If not null, the options are only checked, and
+ *                        their names collected here; otherwise they are
+ *                        added, and must already have been checked
+ *
+ * @return A \ref CmdLineError return code
+ */
+template <typename Threading, typename... Ts>
+template <typename U1, typename U2, typename... Us>
+CmdLineError BasicUserOptions<Threading, Ts...>::Load_(
+    internal::BlobReader* reader, std::string_view pool, bool stored,
+    std::pmr::vector<std::string_view>* checked) {
+    const CmdLineError error = Load_<U1>(reader, pool, stored, checked);
+
+    if (error != CmdLineError::kSuccess)
+        return error;
+
+    return Load_<U2, Us...>(reader, pool, stored, checked);
+}
+
+/**
+ * Compile-time recursive base case of this method
+ */
+template <typename Threading, typename... Ts>
+template <typename U>
+bool BasicUserOptions<Threading, Ts...>::Save_(std::string* blob,
+                                               std::string* pool) const {
+    const auto& options = std::get<OptionSet<U>>(options_);
+
+    internal::AppendBlob(static_cast<std::uint64_t>(options.Size()), blob);
+
+    for (std::size_t i = 0; i < options.Slots(); i++) {
+        if (!options.Live(i)) continue;
+
+        internal::BlobEntry entry;
+        if (!internal::PoolString(options.Name(i), pool, &entry.name) ||
+            !internal::PoolString(options.Description(i), pool,
+                                  &entry.description)) {
+            return false;
+        }
+
+        internal::AppendBlob(entry, blob);
+    }
+
+    for (std::size_t i = 0; i < options.Slots(); i++) {
+        if (options.Live(i) &&
+            !internal::AppendValue(options.DefaultValue(i), blob, pool))
+            return false;
+    }
+
+    for (std::size_t i = 0; i < options.Slots(); i++) {
+        if (options.Live(i) &&
+            !internal::AppendValue(options.CurrentValue(i), blob, pool))
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * Write the options of each type to a binary snapshot
+ *
+ * @param[in,out] blob The snapshot
+ * @param[in,out] pool The snapshot's string pool
+ *
+ * @return False if the pool is full
+ */
+template <typename Threading, typename... Ts>
+template <typename U1, typename U2, typename... Us>
+bool BasicUserOptions<Threading, Ts...>::Save_(std::string* blob,
+                                               std::string* pool) const {
+    return Save_<U1>(blob, pool) && Save_<U2, Us...>(blob, pool);
+}
+
+/**
+ * Hash the names of the supported types, in order, so that a binary
+ * snapshot is only read by options with the same layout
+ *
+ * @return The hash value
+ */
+template <typename Threading, typename... Ts>
+std::uint64_t BasicUserOptions<Threading, Ts...>::TypesHash() noexcept {
+    std::uint64_t hash = 0;
+
+    for (std::string_view name : { std::string_view(
+             internal::TypeToName<Ts>::value)... }) {
+        hash = hash * 1099511628211ull ^ internal::HashName(name);
+    }
+
+    return hash;
+}
+
+/**
+ * Compile-time recursive base case of this function
+ * 
+ * @return 0
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+constexpr std::size_t
+BasicUserOptions<Threading, Ts...>::TypeIndex_() noexcept {
+    return 0;
+}
+
+/**
+ * Get the position of a type within a parameter pack
+ * 
+ * @return The index of T within U, Us...
+ */
+template <typename Threading, typename... Ts>
+template <typename T, typename U, typename... Us>
+constexpr std::size_t
+BasicUserOptions<Threading, Ts...>::TypeIndex_() noexcept {
+    return std::is_same<T,U>::value ? 0 : 1 + TypeIndex_<T, Us...>();
+}
 
-    bool valid = false;
-    auto iter = Find<T>(name, &valid);
+/**
+ * Get the position of a supported type within Ts...
+ * 
+ * @tparam T The type to look up
+ * 
+ * @return The index of this type
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+constexpr std::size_t BasicUserOptions<Threading, Ts...>::TypeIndex() noexcept {
+    static_assert(IsSupported<T>(), "Non-supported type");
+    return TypeIndex_<T, Ts...>();
+}
 
-    if (!valid)
-        return CmdLineError::kWrongType;
+/**
+ * Compile-time recursive base case of this method
+ */
+template <typename Threading, typename... Ts>
+template <typename U>
+void BasicUserOptions<Threading, Ts...>::Accumulate_(
+    HelpIndex* options) const {
+    const auto& set = std::get<OptionSet<U>>(options_);
 
-    *value = iter->DefaultValue();
+    for (std::size_t i = 0; i < set.Slots(); i++) {
+        if (set.Live(i))
+            options->push_back(Describe_<U>({ TypeIndex<U>(), i }));
+    }
+}
 
-    return CmdLineError::kSuccess;
+/**
+ * Gather all options
+ *
+ * @param[out] options Every option registered via \ref Add() is appended
+ *                     to this
+ */
+template <typename Threading, typename... Ts>
+template <typename U1, typename U2, typename... Us>
+void BasicUserOptions<Threading, Ts...>::Accumulate_(
+    HelpIndex* options) const {
+    Accumulate_<U1>(options);
+    Accumulate_<U2, Us...>(options);
 }
 
 /**
  * Compile-time recursive base case of this method
  */
-template <typename... Ts>
+template <typename Threading, typename... Ts>
 template <typename U>
-CmdLineError UserOptions<Ts...>::Delete_(const std::string& name) {
-    auto& options = std::get<OptionSet<U>>(options_);
+auto BasicUserOptions<Threading, Ts...>::Describe_(const Slot& slot) const
+    -> OptionInfo {
+    const auto& options = std::get<OptionSet<U>>(options_);
+
+    return { options.Name(slot.index),
+             options.Description(slot.index),
+             internal::TypeToName<U>::value,
+             internal::ToString(options.DefaultValue(slot.index)) };
+}
+
+/**
+ * Describe the option at the given location, for printing
+ *
+ * @param[in] slot The location of the option
+ *
+ * @return The name, description, type and default of the option
+ */
+template <typename Threading, typename... Ts>
+template <typename U1, typename U2, typename... Us>
+auto BasicUserOptions<Threading, Ts...>::Describe_(const Slot& slot) const
+    -> OptionInfo {
+    if (slot.type == TypeIndex<U1>())
+        return Describe_<U1>(slot);
+
+    return Describe_<U2, Us...>(slot);
+}
+
+/**
+ * Get every option sorted by name, building the list if it has not been
+ * built since the last \ref Add() or \ref Delete()
+ *
+ * @return The sorted options
+ */
+template <typename Threading, typename... Ts>
+auto BasicUserOptions<Threading, Ts...>::Help() const
+    -> std::shared_ptr<const HelpIndex> {
+    if (std::shared_ptr<const HelpIndex> help = help_.Load())
+        return help;
+
+    const std::pmr::polymorphic_allocator<HelpIndex> allocator(Resource());
+
+    auto help = std::allocate_shared<HelpIndex>(allocator);
+
+    help->reserve(index_.size());
+    Accumulate_<Ts...>(help.get());
+
+    std::sort(help->begin(), help->end(),
+        [](const OptionInfo& opt1, const OptionInfo& opt2) {
+            return opt1.name < opt2.name;
+        });
+
+    help_.Store(help);
+
+    return help;
+}
+
+/**
+ * Constructor
+ *
+ * @param[in] resource Allocates the names and their locations
+ */
+template <typename Threading, typename... Ts>
+BasicUserOptions<Threading, Ts...>::NameIndex::NameIndex(
+    std::pmr::memory_resource* resource)
+    : names(resource), slots(resource) {
+}
+
+/**
+ * Copy a name index into another memory resource
+ *
+ * @param[in] index    The index to copy
+ * @param[in] resource Allocates the copy
+ */
+template <typename Threading, typename... Ts>
+BasicUserOptions<Threading, Ts...>::NameIndex::NameIndex(
+    const NameIndex& index, std::pmr::memory_resource* resource)
+    : names(index.names, resource), slots(resource) {
+    slots.reserve(index.slots.size());
+
+    for (const auto& entry : index.slots) {
+        const std::size_t offset = entry.first.data() - index.names.data();
+
+        slots.emplace(
+            std::string_view(names.data() + offset, entry.first.size()),
+            entry.second);
+    }
+}
 
-    auto iter = std::find_if(options.begin(), options.end(),
-            [ &name ](const auto& option) { return option.Name() == name; });
+/**
+ * Get a copy of every option name and its location, building it if it has
+ * not been built since the last \ref Add() or \ref Delete()
+ *
+ * @return The names
+ */
+template <typename Threading, typename... Ts>
+auto BasicUserOptions<Threading, Ts...>::Index() const
+    -> std::shared_ptr<const NameIndex> {
+    if (std::shared_ptr<const NameIndex> names = names_.Load())
+        return names;
+
+    const std::pmr::polymorphic_allocator<NameIndex> allocator(Resource());
+
+    auto names = std::allocate_shared<NameIndex>(allocator, Resource());
+
+    std::size_t size = 0;
+    for (const auto& entry : index_)
+        size += entry.first.size();
+
+    // Reserve all of the storage up front, so the views into it stay valid
+
+    names->names.reserve(size);
+    names->slots.reserve(index_.size());
 
-    if (iter != options.end()) {
-        options.erase(iter); return CmdLineError::kSuccess;
+    for (const auto& entry : index_) {
+        const char* data = names->names.data() + names->names.size();
+        names->names.append(entry.first);
+
+        names->slots.emplace(std::string_view(data, entry.first.size()),
+                             entry.second);
     }
 
-    return CmdLineError::kDoesNotExist;
+    names_.Store(names);
+
+    return names;
 }
 
 /**
- * Check for the existence of an option by name
+ * Find an option
  * 
- * @param[in] name The name of the option to search for
+ * @param[in]  name  The option name
+ * @param[out] error A \ref CmdLineError code indicating why the option was
+ *                   not found
  * 
- * @return A \ref CmdLineError return code
+ * @return The index of the option within its \ref OptionSet, valid only if
+ *         \a error is kSuccess
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+std::size_t BasicUserOptions<Threading, Ts...>::Find(std::string_view name,
+                                                     CmdLineError* error)
+    const {
+    const Slot* slot = Locate(name);
+
+    if (slot == nullptr) {
+        *error = CmdLineError::kDoesNotExist; return 0;
+    }
+
+    if (slot->type != TypeIndex<T>()) {
+        *error = CmdLineError::kWrongType; return 0;
+    }
+
+    *error = CmdLineError::kSuccess;
+    return slot->index;
+}
+
+/**
+ * Find the location of an option. Names in the schema the options were
+ * registered from cost one hash and one compare; others are looked up in
+ * \ref index_
+ *
+ * @param[in] name The option name
+ *
+ * @return The location of the option, or null if there is no such option
+ */
+template <typename Threading, typename... Ts>
+auto BasicUserOptions<Threading, Ts...>::Locate(std::string_view name) const
+    -> const Slot* {
+    if (schema_ != nullptr) {
+        const std::size_t position = schema_find_(schema_.get(), name);
+
+        if (position < schema_slots_.size() &&
+            schema_slots_[position].type < sizeof...(Ts)) {
+            return &schema_slots_[position];
+        }
+    }
+
+    auto iter = index_.find(name);
+    return iter == index_.end() ? nullptr : &iter->second;
+}
+
+/**
+ * Resolve names through a schema's perfect hash from now on. Called by
+ * Schema::Register() once the schema's options have been added
+ *
+ * @param[in] schema A copy of the schema, shared with copies of these
+ *                   options
+ * @param[in] find   Looks up a name in \a schema
+ * @param[in] names  The names in \a schema, by position
+ * @param[in] count  The number of names
+ */
+template <typename Threading, typename... Ts>
+void BasicUserOptions<Threading, Ts...>::BindSchema(
+    std::shared_ptr<const void> schema,
+    std::size_t (*find)(const void*, std::string_view),
+    const std::string_view* names,
+    std::size_t count) {
+    schema_slots_.assign(count, Slot{ sizeof...(Ts), 0 });
+
+    for (std::size_t i = 0; i < count; i++) {
+        auto iter = index_.find(names[i]);
+        if (iter != index_.end()) schema_slots_[i] = iter->second;
+    }
+
+    schema_      = std::move(schema);
+    schema_find_ = find;
+}
+
+/**
+ * Constructor
+ *
+ * @param[in] resource The memory resource to allocate from
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+BasicUserOptions<Threading, Ts...>::OptionSet<T>::OptionSet(
+    std::pmr::memory_resource* resource)
+    : values_(resource), defaults_(resource), names_(resource),
+      descriptions_(resource), versions_(resource), free_(resource) {
+}
+
+/**
+ * Add an option, in the most recently emptied slot if there is one
+ *
+ * @param[in] name          The option name
+ * @param[in] description   A description for this option
+ * @param[in] default_value The option's default value
+ *
+ * @return The index of the option's slot
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+std::size_t BasicUserOptions<Threading, Ts...>::OptionSet<T>::Add(
+    std::string_view name, std::string_view description,
+    const ValueType& default_value) {
+    static_assert(BasicUserOptions<Threading, Ts...>::IsSupported<T>(),
+                  "Non-supported type");
+
+    /*
+     * If copying the value throws, no option is added: every column has
+     * room made first, and a value copied without its default is taken
+     * back. A free slot is claimed only once both are copied
+     */
+    if (free_.empty()) {
+        internal::ReserveMore(1, &values_);
+        internal::ReserveMore(1, &defaults_);
+        internal::ReserveMore(1, &names_);
+        internal::ReserveMore(1, &descriptions_);
+        internal::ReserveMore(1, &versions_);
+
+        values_.emplace_back(default_value);
+
+        struct Undo {
+            decltype(values_)* values;
+            ~Undo() { if (values != nullptr) values->pop_back(); }
+        } undo{ &values_ };
+
+        defaults_.push_back(default_value);
+        undo.values = nullptr;
+
+        names_.push_back(name);
+        descriptions_.push_back(description);
+        versions_.push_back(0);
+
+        return names_.size() - 1;
+    }
+
+    const std::size_t index = free_.back();
+
+    values_[index].Store(default_value);
+    defaults_[index]     = default_value;
+    names_[index]        = name;
+    descriptions_[index] = description;
+
+    free_.pop_back();
+
+    return index;
+}
+
+/**
+ * Assign a value to an option
+ *
+ * @param[in] index The index of the option
+ * @param[in] value The value to give to this option
+ *
+ * @return True if this changed the value
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+bool BasicUserOptions<Threading, Ts...>::OptionSet<T>::Assign(
+    std::size_t index, const ValueType& value)
+    noexcept(std::is_trivially_copyable<T>::value) {
+    auto& cell = values_[index];
+
+    bool changed = true;
+    cell.Read([&](const ValueType& current) {
+        // NaN is unequal even to itself, but replacing it with NaN changes
+        // nothing a listener could see
+
+        if constexpr (std::is_floating_point<T>::value) {
+            changed = !(current == value ||
+                        (current != current && value != value));
+        } else {
+            changed = current != value;
+        }
+    });
+
+    if (changed)
+        cell.Store(value);
+
+    return changed;
+}
+
+/**
+ * Get the current value of an option
+ *
+ * @param[in] index The index of the option
+ *
+ * @return The current value
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+auto BasicUserOptions<Threading, Ts...>::OptionSet<T>::CurrentValue(
+    std::size_t index) const noexcept(std::is_trivially_copyable<T>::value)
+    -> ValueType {
+    return values_[index].Load();
+}
+
+/**
+ * Get the default value of an option
+ *
+ * @param[in] index The index of the option
+ *
+ * @return The default value
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+auto BasicUserOptions<Threading, Ts...>::OptionSet<T>::DefaultValue(
+    std::size_t index) const noexcept(std::is_trivially_copyable<T>::value)
+    -> ValueType {
+    return defaults_[index];
+}
+
+/**
+ * Get the description of an option
+ *
+ * @param[in] index The index of the option
+ *
+ * @return The option's description
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+std::string_view
+BasicUserOptions<Threading, Ts...>::OptionSet<T>::Description(
+    std::size_t index) const noexcept {
+    return descriptions_[index];
+}
+
+/**
+ * Get the name of an option
+ *
+ * @param[in] index The index of the option
+ *
+ * @return The option's name
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+std::string_view BasicUserOptions<Threading, Ts...>::OptionSet<T>::Name(
+    std::size_t index) const noexcept {
+    return names_[index];
+}
+
+/**
+ * Check if a slot holds an option
+ *
+ * @param[in] index The index of the slot
+ *
+ * @return True unless the slot's option was removed and not yet replaced
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+bool BasicUserOptions<Threading, Ts...>::OptionSet<T>::Live(
+    std::size_t index) const noexcept {
+    return !names_[index].empty();
+}
+
+/**
+ * Pass the current value of an option to a function, without copying it
+ *
+ * @param[in] index  The index of the option
+ * @param[in] reader Invoked with a const reference to the value
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+template <typename F>
+void BasicUserOptions<Threading, Ts...>::OptionSet<T>::ReadValue(
+    std::size_t index, F&& reader) const {
+    values_[index].Read(std::forward<F>(reader));
+}
+
+/**
+ * Point the name and description of every option at the stored copy in an
+ * arena, copying them into it if they are not there yet
+ *
+ * @param[in] strings The arena
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+void BasicUserOptions<Threading, Ts...>::OptionSet<T>::Reintern(
+    internal::StringArena* strings) {
+    for (std::string_view& name : names_)
+        name = strings->Intern(name);
+
+    for (std::string_view& description : descriptions_)
+        description = strings->Intern(description);
+}
+
+/**
+ * Remove an option, emptying its slot for reuse. No other option moves
+ *
+ * @param[in] index The index of the option
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+void BasicUserOptions<Threading, Ts...>::OptionSet<T>::Remove(
+    std::size_t index) {
+    free_.push_back(index);
+
+    // Release any memory held by the values
+
+    values_[index].Store(ValueType());
+    defaults_[index]     = ValueType();
+    names_[index]        = {};
+    descriptions_[index] = {};
+
+    versions_[index]++;
+}
+
+/**
+ * Make room for more options, so that adding them does not reallocate
+ *
+ * @param[in] count The number of options that will be added
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+void BasicUserOptions<Threading, Ts...>::OptionSet<T>::Reserve(
+    std::size_t count) {
+    internal::ReserveMore(count, &values_);
+    internal::ReserveMore(count, &defaults_);
+    internal::ReserveMore(count, &names_);
+    internal::ReserveMore(count, &descriptions_);
+    internal::ReserveMore(count, &versions_);
+}
+
+/**
+ * Get the number of options in this set
+ *
+ * @return The number of options
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+std::size_t
+BasicUserOptions<Threading, Ts...>::OptionSet<T>::Size() const noexcept {
+    return names_.size() - free_.size();
+}
+
+/**
+ * Get the number of slots in this set, empty or not
+ *
+ * @return One past the index of the last slot
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+std::size_t
+BasicUserOptions<Threading, Ts...>::OptionSet<T>::Slots() const noexcept {
+    return names_.size();
+}
+
+/**
+ * Get the version of a slot, which changes whenever the slot is emptied
+ *
+ * @param[in] index The index of the slot
+ *
+ * @return The number of times the slot has been emptied
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+std::uint32_t BasicUserOptions<Threading, Ts...>::OptionSet<T>::Version(
+    std::size_t index) const noexcept {
+    return versions_[index];
+}
+
+/**
+ * Constructor
+ *
+ * @param[in] options The set of options of type T
+ * @param[in] index   The index of the option within \a options
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+BasicUserOptions<Threading, Ts...>::OptionHandle<T>::OptionHandle(
+    const OptionSet<T>* options, std::size_t index)
+    : options_(options), index_(index), version_(options->Version(index)) {
+}
+
+/**
+ * Get the default value of the option
+ *
+ * @return The default value, or a value-initialized T if the option has
+ *         been deleted since this handle was bound
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+T BasicUserOptions<Threading, Ts...>::OptionHandle<T>::Default() const
+    noexcept(std::is_trivially_copyable<T>::value) {
+    if (!Valid())
+        return T();
+
+    return options_->DefaultValue(index_);
+}
+
+/**
+ * Pass the current value of the option to a function, without copying it.
+ * For a \ref Concurrent string option, this is the way to read the value
+ * without allocating
+ *
+ * @param[in] reader Invoked with a const reference to the value, or to a
+ *                   value-initialized T if the option has been deleted
+ *                   since this handle was bound
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+template <typename F>
+void
+BasicUserOptions<Threading, Ts...>::OptionHandle<T>::Read(F&& reader) const {
+    if (!Valid()) {
+        const T value = T();
+        std::forward<F>(reader)(value);
+        return;
+    }
+
+    options_->ReadValue(index_, std::forward<F>(reader));
+}
+
+/**
+ * Check if this handle is bound to an option that still exists. Like
+ * \ref BasicUserOptions::Delete() itself, this is not thread-safe
+ *
+ * @return True if bound via \ref BasicUserOptions::Bind() and the option
+ *         has not since been deleted
+ */
+template <typename Threading, typename... Ts>
+template <typename T>
+bool
+BasicUserOptions<Threading, Ts...>::OptionHandle<T>::Valid() const noexcept {
+    return options_ != nullptr && options_->Version(index_) == version_;
+}
+
+/**
+ * Get the current value of the option. A handle whose option was deleted
+ * never reads an option that has since taken its slot
+ *
+ * @return The current value, or a value-initialized T if the option has
+ *         been deleted since this handle was bound
  */
-template <typename... Ts>
-template <typename U1, typename U2, typename... Us>
-CmdLineError UserOptions<Ts...>::Delete_(const std::string& name) {
-    if (Delete_<U1>(name) == CmdLineError::kDoesNotExist)
-        return Delete_<U2, Us...>(name);
+template <typename Threading, typename... Ts>
+template <typename T>
+T BasicUserOptions<Threading, Ts...>::OptionHandle<T>::Value() const
+    noexcept(std::is_trivially_copyable<T>::value) {
+    if (!Valid())
+        return T();
 
-    return CmdLineError::kSuccess;
+    return options_->CurrentValue(index_);
 }
 
 /**
- * Delete an option
- * 
- * @param[in] name The name of the option to delete
- * 
- * @return A \ref CmdLineError return code
+ * Constructor. Opens a batch
+ *
+ * @param[in] options The options whose notifications are held
  */
-template <typename... Ts>
-CmdLineError UserOptions<Ts...>::Delete(const std::string& name) {
-    return Delete_<Ts...>(name);
+template <typename Threading, typename... Ts>
+BasicUserOptions<Threading, Ts...>::Batch::Batch(
+    BasicUserOptions* options) noexcept
+    : options_(options), exceptions_(std::uncaught_exceptions()) {
+    options_->BeginBatch();
 }
 
 /**
- * Compile-time recursive base case of this method
+ * Destructor. Closes the batch, delivering the held notifications if it
+ * is the outermost one and no exception is leaving its scope
  */
-template <typename... Ts>
-template <typename U>
-bool UserOptions<Ts...>::Exists_(const std::string& name) const {
-    const auto& options = std::get<OptionSet<U>>(options_);
-
-    auto iter = std::find_if(options.begin(), options.end(),
-            [ &name ](const auto& option) { return option.Name() == name; });
-
-    if (iter != options.end()) return true;
-
-    return false;
+template <typename Threading, typename... Ts>
+BasicUserOptions<Threading, Ts...>::Batch::~Batch() noexcept(false) {
+    if (std::uncaught_exceptions() > exceptions_)
+        options_->AbortBatch();
+    else
+        options_->EndBatch();
 }
 
 /**
- * Check for the existence of an option by name
- * 
- * @param[in] name The name of the option to search for
- * 
- * @return True if the option exists
+ * Constructor
+ *
+ * @param[in] owner The options from which this snapshot is staged
  */
-template <typename... Ts>
-template <typename U1, typename U2, typename... Us>
-bool UserOptions<Ts...>::Exists_(const std::string& name) const {
-    if (!Exists_<U1>(name))
-        return Exists_<U2, Us...>(name);
+template <typename Threading, typename... Ts>
+BasicUserOptions<Threading, Ts...>::Snapshot::Snapshot(
+    const BasicUserOptions* owner)
+    : names_(owner->Index()), generation_(0),
+      values_(std::pmr::vector<Ts>(owner->Resource())...),
+      versions_(Versions<Ts>(owner->Resource())...) {
+}
 
-    return true;
+/**
+ * Copy a snapshot into another memory resource, names and all
+ *
+ * @param[in] snapshot The snapshot to copy
+ * @param[in] resource Allocates the copy
+ */
+template <typename Threading, typename... Ts>
+BasicUserOptions<Threading, Ts...>::Snapshot::Snapshot(
+    const Snapshot& snapshot, std::pmr::memory_resource* resource)
+    : names_(std::allocate_shared<NameIndex>(
+          std::pmr::polymorphic_allocator<NameIndex>(resource),
+          *snapshot.names_, resource)),
+      generation_(snapshot.generation_),
+      values_(std::pmr::vector<Ts>(
+          std::get<std::pmr::vector<Ts>>(snapshot.values_), resource)...),
+      versions_(Versions<Ts>(
+          std::get<TypeIndex<Ts>()>(snapshot.versions_), resource)...) {
 }
 
 /**
- * Check for the existence of an option by name
- * 
- * @param[in] name The name of the option to search for
- * 
- * @return True if the option exists
+ * Get the generation of this snapshot, which increases by one with each
+ * publication
+ *
+ * @return The generation, or 0 if this snapshot was never published
  */
-template <typename... Ts>
-bool UserOptions<Ts...>::Exists(const std::string& name) const {
-    return Exists_<Ts...>(name);
+template <typename Threading, typename... Ts>
+std::uint64_t
+BasicUserOptions<Threading, Ts...>::Snapshot::Generation() const noexcept {
+    return generation_;
 }
 
 /**
- * Get the current value of an option
- * 
+ * Get the value of an option as of this snapshot
+ *
  * @param[in]  name  The name of the option
- * @param[out] value The current value of this option
- * 
+ * @param[out] value The value of this option
+ *
  * @return A \ref CmdLineError return code
  */
-template <typename... Ts>
+template <typename Threading, typename... Ts>
 template <typename T>
-CmdLineError UserOptions<Ts...>::Get(const std::string& name, T* value) const {
-    const std::string trimmed = superstring(name).trim();
-
-    if (trimmed.empty())
+CmdLineError
+BasicUserOptions<Threading, Ts...>::Snapshot::Get(const std::string& name,
+                                                  T* value) const {
+    if (internal::IsBlank(name))
         return CmdLineError::kEmptyName;
 
-    if (!Exists(name))
-        return CmdLineError::kDoesNotExist;
-
-    bool valid = false;
-    auto iter = Find<T>(name, &valid);
+    CmdLineError error;
+    const std::size_t index = Locate<T>(name, &error);
 
-    if (!valid)
-        return CmdLineError::kWrongType;
+    if (error != CmdLineError::kSuccess)
+        return error;
 
-    *value = iter->CurrentValue();
+    *value = std::get<std::pmr::vector<T>>(values_)[index];
 
     return CmdLineError::kSuccess;
 }
 
 /**
- * Set the value of an option
- * 
- * @param[in]  name  The name of the option
- * @param[out] value The value to assign this option
- * 
+ * Set the value of an option within this snapshot. This has no effect on
+ * the options until the snapshot is published
+ *
+ * @param[in] name  The name of the option
+ * @param[in] value The value to assign this option
+ *
  * @return A \ref CmdLineError return code
  */
-template <typename... Ts>
+template <typename Threading, typename... Ts>
 template <typename T>
-CmdLineError UserOptions<Ts...>::Set(const std::string& name, const T& value) {
-    const std::string trimmed = superstring(name).trim();
-
-    if (trimmed.empty())
+CmdLineError
+BasicUserOptions<Threading, Ts...>::Snapshot::Set(const std::string& name,
+                                                  const T& value) {
+    if (internal::IsBlank(name))
         return CmdLineError::kEmptyName;
 
-    if (!Exists(name))
-        return CmdLineError::kDoesNotExist;
-
-    bool valid = false;
-    auto iter = Load<T>(name, &valid);
+    CmdLineError error;
+    const std::size_t index = Locate<T>(name, &error);
 
-    if (!valid)
-        return CmdLineError::kWrongType;
+    if (error != CmdLineError::kSuccess)
+        return error;
 
-    iter->Assign(value);
+    std::get<std::pmr::vector<T>>(values_)[index] = value;
 
     return CmdLineError::kSuccess;
 }
 
 /**
- * Print all command line options for the program
+ * Set the value of an option within this snapshot from its string
+ * representation, converting it to the option's type
  *
- * @param[in] prog_name Usually the 1st command line argument, which
- *                      is the executable name
- * @param[in] os        The output stream object to write to
+ * @param[in] name  The name of the option
+ * @param[in] value The string to convert
+ *
+ * @return A \ref CmdLineError return code
  */
-template <typename... Ts>
-void UserOptions<Ts...>::Print(const char* prog_name, std::ostream& os) const {
-    std::vector<const Option*> options = Accumulate();
-
-    auto compare = [](const Option* opt1, const Option* opt2) {
-        return opt1->Name().compare(opt2->Name()) < 0;
-    };
-
-    std::sort(options.begin(), options.end(), compare);
+template <typename Threading, typename... Ts>
+CmdLineError BasicUserOptions<Threading, Ts...>::Snapshot::SetFromString(
+    std::string_view name, std::string_view value) {
+    if (internal::IsBlank(name))
+        return CmdLineError::kEmptyName;
 
-    os << "usage: " << prog_name << " [options]\n";
-    os << "options:\n\n";
+    const auto iter = names_->slots.find(name);
+    if (iter == names_->slots.end())
+        return CmdLineError::kDoesNotExist;
 
-    for (std::size_t i = 0; i < options.size(); i++)
-        options[i]->Print();
+    return SetFromString_<Ts...>(iter->second, value);
 }
 
 /**
- * Compile-time recursive base case of this function
- * 
- * @return false
+ * Get the value of a bound option as of this snapshot
+ *
+ * @param[in] handle A handle bound to the option
+ *
+ * @return The value, or the option's default if it was added after this
+ *         snapshot was staged
  */
-template <typename... Ts>
+template <typename Threading, typename... Ts>
 template <typename T>
-constexpr bool UserOptions<Ts...>::IsSupported_() noexcept {
-    return false;
+T BasicUserOptions<Threading, Ts...>::Snapshot::Value(
+    const OptionHandle<T>& handle) const {
+    if (Staged<T>(handle.index_, handle.version_))
+        return std::get<std::pmr::vector<T>>(values_)[handle.index_];
+
+    return handle.Default();
 }
 
 /**
- * Check if a type is supported by this library
- * 
- * @return True if supported
+ * Find the index of an option's value within this snapshot
+ *
+ * @param[in]  name  The name of the option
+ * @param[out] error A \ref CmdLineError return code
+ *
+ * @return The index, valid only if \a error is kSuccess
  */
-template <typename... Ts>
-template <typename T, typename U, typename... Us>
-constexpr bool UserOptions<Ts...>::IsSupported_() noexcept {
-    return std::is_same<T,U>::value || IsSupported_<T, Us...>();
+template <typename Threading, typename... Ts>
+template <typename T>
+std::size_t
+BasicUserOptions<Threading, Ts...>::Snapshot::Locate(const std::string& name,
+                                                     CmdLineError* error)
+    const {
+    const auto iter = names_->slots.find(name);
+
+    if (iter == names_->slots.end()) {
+        *error = CmdLineError::kDoesNotExist; return 0;
+    }
+
+    if (iter->second.type != TypeIndex<T>()) {
+        *error = CmdLineError::kWrongType; return 0;
+    }
+
+    *error = CmdLineError::kSuccess;
+    return iter->second.index;
 }
 
 /**
- * Check if the given type is supported by this library, i.e. it may be used
- * as a command line option
- * 
- * @tparam T The type to check
- * 
- * @return True if this type is supported
+ * Check if this snapshot holds the value of the option in a slot
+ *
+ * @tparam U The type of the option
+ *
+ * @param[in] index   The index of the slot
+ * @param[in] version The version of the slot holding the option
+ *
+ * @return False if the option was added after this snapshot was staged
  */
-template <typename... Ts>
-template <typename T>
-constexpr bool UserOptions<Ts...>::IsSupported() noexcept {
-    return IsSupported_<T, Ts...>();
+template <typename Threading, typename... Ts>
+template <typename U>
+bool BasicUserOptions<Threading, Ts...>::Snapshot::Staged(
+    std::size_t index, std::uint32_t version) const noexcept {
+    const auto& versions = std::get<TypeIndex<U>()>(versions_);
+
+    return index < versions.size() && versions[index] == version;
 }
 
 /**
  * Compile-time recursive base case of this method
  */
-template <typename... Ts>
+template <typename Threading, typename... Ts>
 template <typename U>
-auto UserOptions<Ts...>::Accumulate_() const -> std::vector<const Option*> {
-    std::vector<const Option*> aggregate;
+CmdLineError BasicUserOptions<Threading, Ts...>::Snapshot::SetFromString_(
+    const Slot& slot, std::string_view value) {
+    auto& values = std::get<std::pmr::vector<U>>(values_);
 
-    const auto& options = std::get<OptionSet<U>>(options_);
+    U converted;
+    const CmdLineError error = internal::FromString(value, &converted);
 
-    for (std::size_t i = 0; i < options.size(); i++) {
-        aggregate.push_back(&options[i]);
-    }
+    if (error == CmdLineError::kSuccess)
+        values[slot.index] = converted;
 
-    return aggregate;
+    return error;
 }
 
 /**
- * Gather all options
+ * Convert and assign the value at the given location
  *
- * @return All options registered via \ref Add()
+ * @param[in] slot  The location of the option
+ * @param[in] value The string to convert
+ *
+ * @return A \ref CmdLineError return code
  */
-template <typename... Ts>
+template <typename Threading, typename... Ts>
 template <typename U1, typename U2, typename... Us>
-auto UserOptions<Ts...>::Accumulate_() const -> std::vector<const Option*> {
-    std::vector<const Option*> aggregate = Accumulate_<U1>();
-
-    std::vector<const Option*> partial = Accumulate_<U2, Us...>();
+CmdLineError BasicUserOptions<Threading, Ts...>::Snapshot::SetFromString_(
+    const Slot& slot, std::string_view value) {
+    if (slot.type == TypeIndex<U1>())
+        return SetFromString_<U1>(slot, value);
 
-    aggregate.insert(aggregate.end(), partial.begin(), partial.end());
+    return SetFromString_<U2, Us...>(slot, value);
+}
 
-    return aggregate;
+/**
+ * Constructor
+ *
+ * @param[in] base The options to layer over
+ */
+template <typename Threading, typename... Ts>
+BasicUserOptions<Threading, Ts...>::Overlay::Overlay(
+    const BasicUserOptions& base)
+    : Overlay(base, base.Resource()) {
 }
 
 /**
- * Gather all options
+ * Constructor
  *
- * @return All options registered via \ref Add()
+ * @param[in] base     The options to layer over
+ * @param[in] resource The memory resource to allocate overrides from
  */
-template <typename... Ts>
-auto UserOptions<Ts...>::Accumulate() const -> std::vector<const Option*> {
-    return Accumulate_<Ts...>();
+template <typename Threading, typename... Ts>
+BasicUserOptions<Threading, Ts...>::Overlay::Overlay(
+    const BasicUserOptions& base, std::pmr::memory_resource* resource)
+    : base_(&base), overrides_(Overrides<Ts>(resource)...) {
 }
 
 /**
- * Find an option
- * 
- * @param[in]  name  The option name
- * @oaram[out] valid True if the return value is a valid iterator
- * 
- * @return An iterator to the option
+ * Get the value of an option, overridden or from the base
+ *
+ * @param[in]  name  The name of the option
+ * @param[out] value The value of this option
+ *
+ * @return A \ref CmdLineError return code
  */
-template <typename... Ts>
+template <typename Threading, typename... Ts>
 template <typename T>
-auto UserOptions<Ts...>::Find(const std::string& name, bool* valid) const
-    -> typename std::vector<TypedOption<T>>::const_iterator {
-    const std::vector<TypedOption<T>>& options =
-        std::get<OptionSet<T>>(options_);
+CmdLineError
+BasicUserOptions<Threading, Ts...>::Overlay::Get(const std::string& name,
+                                                 T* value) const {
+    if (internal::IsBlank(name))
+        return CmdLineError::kEmptyName;
+
+    CmdLineError error;
+    const std::size_t index = base_->template Find<T>(name, &error);
 
-    auto iter = std::find_if(options.begin(), options.end(),
-            [ &name ](const auto& option) { return option.Name() == name; });
+    if (error != CmdLineError::kSuccess)
+        return error;
 
-    *valid = iter != options.end();
-    return iter;
+    const Override<T>* entry = Find<T>(index);
+
+    *value = entry != nullptr ?
+        entry->value : std::get<OptionSet<T>>(base_->options_)
+                           .CurrentValue(index);
+
+    return CmdLineError::kSuccess;
 }
 
 /**
- * Load an option. Similar to \ref Find(), but returns a non-const iterator
- * 
- * @param[in]  name  The option name
- * @oaram[out] valid True if the return value is a valid iterator
- * 
- * @return An iterator to the option
+ * Check if this overlay overrides an option
+ *
+ * @param[in] name The name of the option
+ *
+ * @return True if the option exists and has a value in this overlay
  */
-template <typename... Ts>
-template <typename T>
-auto UserOptions<Ts...>::Load(const std::string& name, bool* valid)
-    -> typename std::vector<TypedOption<T>>::iterator {
-    std::vector<TypedOption<T>>& options = std::get<OptionSet<T>>(options_);
+template <typename Threading, typename... Ts>
+bool BasicUserOptions<Threading, Ts...>::Overlay::Overridden(
+    std::string_view name) const {
+    auto iter = base_->index_.find(name);
+    if (iter == base_->index_.end())
+        return false;
+
+    return Overridden_<Ts...>(iter->second);
+}
+
+/**
+ * Drop the override of an option, so that reads fall through to the base
+ *
+ * @param[in] name The name of the option
+ *
+ * @return A \ref CmdLineError return code, kDoesNotExist if the option is
+ *         not overridden
+ */
+template <typename Threading, typename... Ts>
+CmdLineError
+BasicUserOptions<Threading, Ts...>::Overlay::Reset(std::string_view name) {
+    if (internal::IsBlank(name))
+        return CmdLineError::kEmptyName;
 
-    auto iter = std::find_if(options.begin(), options.end(),
-            [ &name ](const auto& option) { return option.Name() == name; });
+    auto iter = base_->index_.find(name);
+    if (iter == base_->index_.end())
+        return CmdLineError::kDoesNotExist;
 
-    *valid = iter != options.end();
-    return iter;
+    return Reset_<Ts...>(iter->second);
 }
 
 /**
- * Constructor
- * 
- * @param[in] name        The name of this option
- * @param[in] type        The type which holds the value of this option
- * @param[in] description A description for this option
+ * Override the value of an option. The base is unaffected
+ *
+ * @param[in] name  The name of the option
+ * @param[in] value The value to give this option within this overlay
+ *
+ * @return A \ref CmdLineError return code
  */
-template <typename... Ts>
-UserOptions<Ts...>::Option::Option(const std::string& name,
-                                   const std::string& type,
-                                   const std::string& description)
-    : description_(description),
-      name_(name),
-      type_(type) {
+template <typename Threading, typename... Ts>
+template <typename T>
+CmdLineError
+BasicUserOptions<Threading, Ts...>::Overlay::Set(const std::string& name,
+                                                 const T& value) {
+    if (internal::IsBlank(name))
+        return CmdLineError::kEmptyName;
+
+    CmdLineError error;
+    const std::size_t index = base_->template Find<T>(name, &error);
+
+    if (error != CmdLineError::kSuccess)
+        return error;
+
+    const auto& options = std::get<OptionSet<T>>(base_->options_);
+
+    std::get<Overrides<T>>(overrides_).insert_or_assign(
+        index, Override<T>{ value, options.Version(index) });
+
+    return CmdLineError::kSuccess;
 }
 
 /**
- * Get the description for this option
+ * Override the value of an option from its string representation,
+ * converting it to the option's type
  *
- * @return The option's description
+ * @param[in] name  The name of the option
+ * @param[in] value The string to convert
+ *
+ * @return A \ref CmdLineError return code
  */
-template <typename... Ts>
-std::string UserOptions<Ts...>::Option::Description() const {
-    return description_;
+template <typename Threading, typename... Ts>
+CmdLineError BasicUserOptions<Threading, Ts...>::Overlay::SetFromString(
+    std::string_view name, std::string_view value) {
+    if (internal::IsBlank(name))
+        return CmdLineError::kEmptyName;
+
+    auto iter = base_->index_.find(name);
+    if (iter == base_->index_.end())
+        return CmdLineError::kDoesNotExist;
+
+    return SetFromString_<Ts...>(iter->second, value);
 }
 
 /**
- * Get the name of this option
+ * Get the number of options overridden by this overlay. Overrides of
+ * options since deleted from the base are not counted
  *
- * @return The option's name
+ * @return The number of overrides
  */
-template <typename... Ts>
-std::string UserOptions<Ts...>::Option::Name() const {
-    return name_;
+template <typename Threading, typename... Ts>
+std::size_t
+BasicUserOptions<Threading, Ts...>::Overlay::Size() const noexcept {
+    return Size_<Ts...>();
 }
 
 /**
- * Format this option
- * 
- * @param[in] os The stream object to write to
+ * Get the value of a bound option, overridden or from the base
+ *
+ * @param[in] handle A handle bound to an option of the base
+ *
+ * @return The value, or a value-initialized T if the option has been
+ *         deleted since \a handle was bound
  */
-template <typename... Ts>
-void UserOptions<Ts...>::Option::Print(std::ostream& os) const {
-    std::string output =
-        "\t--" + name_ + "=<" + type_ + "> [" + Default() + "]\n\t\t";
+template <typename Threading, typename... Ts>
+template <typename T>
+T BasicUserOptions<Threading, Ts...>::Overlay::Value(
+    const OptionHandle<T>& handle) const {
+    const Override<T>* entry = Find<T>(handle.index_);
 
-    output += description_;
+    if (entry != nullptr && entry->version == handle.version_)
+        return entry->value;
 
-    os << output << std::endl;
+    return handle.Value();
 }
 
 /**
- * Get the data type which holds this option's value
+ * Find the override of an option
+ *
+ * @param[in] index The index of the option's slot in the base
  *
- * @return The option's storage type
+ * @return The override, or nullptr if there is none for the option now in
+ *         this slot
  */
-template <typename... Ts>
-std::string UserOptions<Ts...>::Option::Type() const {
-    return type_;
+template <typename Threading, typename... Ts>
+template <typename T>
+auto BasicUserOptions<Threading, Ts...>::Overlay::Find(
+    std::size_t index) const -> const Override<T>* {
+    const auto& overrides = std::get<Overrides<T>>(overrides_);
+
+    auto iter = overrides.find(index);
+    if (iter == overrides.end())
+        return nullptr;
+
+    const auto& options = std::get<OptionSet<T>>(base_->options_);
+
+    return iter->second.version == options.Version(index) ?
+        &iter->second : nullptr;
 }
 
 /**
- * Constructor
+ * Compile-time recursive base case of this method
+ */
+template <typename Threading, typename... Ts>
+template <typename U>
+bool BasicUserOptions<Threading, Ts...>::Overlay::Overridden_(
+    const Slot& slot) const {
+    return Find<U>(slot.index) != nullptr;
+}
+
+/**
+ * Check for an override at the given location
  *
- * @param [in] name          The option name
- * @param [in] description   A description for this option
- * @param [in] default_value The option's default value
+ * @param[in] slot The location of the option
+ *
+ * @return True if the option in this slot is overridden
  */
-template <typename... Ts>
-template <typename T>
-UserOptions<Ts...>::TypedOption<T>::TypedOption(const std::string& name,
-                                                const std::string& description,
-                                                const ValueType& default_value)
-    : Option(name, internal::TypeToName<T>::value, description),
-      default_(default_value), value_(default_value) {
-    static_assert(UserOptions<Ts...>::IsSupported<T>(), "Non-supported type");
+template <typename Threading, typename... Ts>
+template <typename U1, typename U2, typename... Us>
+bool BasicUserOptions<Threading, Ts...>::Overlay::Overridden_(
+    const Slot& slot) const {
+    if (slot.type == TypeIndex<U1>())
+        return Overridden_<U1>(slot);
+
+    return Overridden_<U2, Us...>(slot);
 }
 
 /**
- * Assign a value to this option
- * 
- * @param[in] value The value to give to this option
+ * Compile-time recursive base case of this method
  */
-template <typename... Ts>
-template <typename T> void
-UserOptions<Ts...>::TypedOption<T>::Assign(const ValueType& value) noexcept {
-    value_ = value;
+template <typename Threading, typename... Ts>
+template <typename U>
+CmdLineError
+BasicUserOptions<Threading, Ts...>::Overlay::Reset_(const Slot& slot) {
+    auto& overrides = std::get<Overrides<U>>(overrides_);
+
+    auto iter = overrides.find(slot.index);
+    if (iter == overrides.end())
+        return CmdLineError::kDoesNotExist;
+
+    // An override of a deleted option is dropped, but was not this one's
+
+    const auto& options = std::get<OptionSet<U>>(base_->options_);
+    const bool current = iter->second.version == options.Version(slot.index);
+
+    overrides.erase(iter);
+
+    return current ? CmdLineError::kSuccess : CmdLineError::kDoesNotExist;
 }
 
 /**
- * Get the current value of this option
+ * Drop the override at the given location
  *
- * @return The current value
+ * @param[in] slot The location of the option
+ *
+ * @return kSuccess if there was an override to drop
  */
-template <typename... Ts>
-template <typename T>
-auto UserOptions<Ts...>::TypedOption<T>::CurrentValue() const noexcept
-    -> ValueType {
-    return value_;
+template <typename Threading, typename... Ts>
+template <typename U1, typename U2, typename... Us>
+CmdLineError
+BasicUserOptions<Threading, Ts...>::Overlay::Reset_(const Slot& slot) {
+    if (slot.type == TypeIndex<U1>())
+        return Reset_<U1>(slot);
+
+    return Reset_<U2, Us...>(slot);
 }
 
 /**
- * @see Option::Default
+ * Compile-time recursive base case of this method
  */
-template <typename... Ts>
-template <typename T>
-std::string UserOptions<Ts...>::TypedOption<T>::Default() const {
-    return internal::ToString(default_);
+template <typename Threading, typename... Ts>
+template <typename U>
+CmdLineError BasicUserOptions<Threading, Ts...>::Overlay::SetFromString_(
+    const Slot& slot, std::string_view value) {
+    U converted;
+    const CmdLineError error = internal::FromString(value, &converted);
+
+    if (error != CmdLineError::kSuccess)
+        return error;
+
+    const auto& options = std::get<OptionSet<U>>(base_->options_);
+
+    std::get<Overrides<U>>(overrides_).insert_or_assign(
+        slot.index, Override<U>{ converted, options.Version(slot.index) });
+
+    return CmdLineError::kSuccess;
 }
 
 /**
- * Get the default value of this option
+ * Convert and override the value at the given location
  *
- * @return The default value
+ * @param[in] slot  The location of the option
+ * @param[in] value The string to convert
+ *
+ * @return A \ref CmdLineError return code
  */
-template <typename... Ts>
-template <typename T>
-auto UserOptions<Ts...>::TypedOption<T>::DefaultValue() const noexcept
-    -> ValueType {
-    return default_;
+template <typename Threading, typename... Ts>
+template <typename U1, typename U2, typename... Us>
+CmdLineError BasicUserOptions<Threading, Ts...>::Overlay::SetFromString_(
+    const Slot& slot, std::string_view value) {
+    if (slot.type == TypeIndex<U1>())
+        return SetFromString_<U1>(slot, value);
+
+    return SetFromString_<U2, Us...>(slot, value);
 }
 
 /**
- * @see Option::Value
+ * Compile-time recursive base case of this method
  */
-template <typename... Ts>
-template <typename T>
-std::string UserOptions<Ts...>::TypedOption<T>::Value() const {
-    return internal::ToString(value_);
+template <typename Threading, typename... Ts>
+template <typename U>
+std::size_t
+BasicUserOptions<Threading, Ts...>::Overlay::Size_() const noexcept {
+    const auto& options = std::get<OptionSet<U>>(base_->options_);
+
+    std::size_t size = 0;
+    for (const auto& entry : std::get<Overrides<U>>(overrides_)) {
+        if (entry.second.version == options.Version(entry.first))
+            size++;
+    }
+
+    return size;
+}
+
+/**
+ * Count the overrides of each type
+ *
+ * @return The number of overrides of types U1, U2, Us...
+ */
+template <typename Threading, typename... Ts>
+template <typename U1, typename U2, typename... Us>
+std::size_t
+BasicUserOptions<Threading, Ts...>::Overlay::Size_() const noexcept {
+    return Size_<U1>() + Size_<U2, Us...>();
 }
 
 }  // namespace jfern
@@ -0,0 +1,594 @@
+/**
+ *  \file   schema.h
+ *  \author Jason Fernandez
+ *  \date   10/16/2026
+ *
+ *  https://github.com/jfern2011/CommandLine
+ */
+
+#ifndef COMMAND_LINE_SCHEMA_H_
+#define COMMAND_LINE_SCHEMA_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+#include "commandline/commandline.h"
+
+namespace jfern {
+namespace internal {
+/**
+ * The type used to hold an option's default value within a schema. Strings
+ * are held as views so that every schema entry is a literal type
+ *
+ * @{
+ */
+template <typename T>
+struct SpecStorage {
+    using type = T;
+};
+template <>
+struct SpecStorage<std::string> {
+    using type = std::string_view;
+};
+/**
+ * @}
+ */
+
+/**
+ * Re-hash a value with a seed (splitmix64)
+ *
+ * @param[in] hash The value to mix
+ * @param[in] seed The seed
+ *
+ * @return The mixed value
+ */
+constexpr std::uint64_t MixHash(std::uint64_t hash,
+                                std::uint64_t seed) noexcept {
+    hash += seed * 0x9e3779b97f4a7c15ull;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+    return hash ^ (hash >> 31);
+}
+
+/**
+ * Round up to a power of two
+ *
+ * @param[in] value The value to round
+ *
+ * @return The smallest power of two that is at least \a value (and at
+ *         least 1)
+ */
+constexpr std::size_t NextPowerOfTwo(std::size_t value) noexcept {
+    std::size_t power = 1;
+    while (power < value) power <<= 1;
+    return power;
+}
+
+}  // namespace internal
+
+/**
+ * A minimal perfect hash over a fixed set of option names, built with the
+ * hash-and-displace method. Names are first grouped into buckets by hash;
+ * each bucket then gets a seed that sends all of its names to free slots.
+ * A lookup costs one string hash, one integer mix and one string compare.
+ *
+ * Construction is constexpr, so a table built from literal names is
+ * computed entirely at compile time. Very large tables may require raising
+ * the compiler's constexpr evaluation limits
+ *
+ * @tparam N The number of names
+ */
+template <std::size_t N>
+class PerfectHash final {
+public:
+    /**
+     * The number of buckets and slots
+     */
+    static constexpr std::size_t kTableSize = internal::NextPowerOfTwo(N);
+
+    /**
+     * The value returned by \ref Find() for a name not in the table
+     */
+    static constexpr std::size_t npos = N;
+
+    constexpr explicit PerfectHash(
+        const std::array<std::string_view, N>& names);
+
+    constexpr std::size_t Find(std::string_view name) const noexcept;
+
+    constexpr bool Valid() const noexcept;
+
+private:
+    /**
+     * The maximum number of seeds tried for a single bucket
+     */
+    static constexpr std::int64_t kMaxSeed = 1 << 16;
+
+    static constexpr std::size_t kMask = kTableSize - 1;
+
+    constexpr void Build();
+
+    /**
+     * The names, in their original order
+     */
+    std::array<std::string_view, N> names_;
+
+    /**
+     * Per bucket: a positive seed for \ref internal::MixHash, or -(slot + 1)
+     * for a bucket holding a single name placed directly
+     */
+    std::array<std::int64_t, kTableSize> seeds_;
+
+    /**
+     * Per slot: the index of the name stored there, or \ref npos
+     */
+    std::array<std::size_t, kTableSize> slots_;
+
+    /**
+     * False if the names contain duplicates or could not be placed
+     */
+    bool valid_;
+};
+
+/**
+ * A single entry in a compile-time option schema
+ *
+ * @tparam T The type of the option
+ */
+template <typename T>
+struct OptionSpec {
+    using ValueType = T;
+
+    std::string_view name;                              ///< Option name
+    typename internal::SpecStorage<T>::type default_value;  ///< Default
+    std::string_view description;                       ///< Description
+};
+
+/**
+ * Create a schema entry
+ *
+ * @tparam T The type of the option
+ *
+ * @param[in] name          The name of the option
+ * @param[in] default_value Its default value
+ * @param[in] desc          A description for the option
+ *
+ * @return The schema entry
+ */
+template <typename T>
+constexpr OptionSpec<T> MakeOption(
+        std::string_view name,
+        typename internal::SpecStorage<T>::type default_value,
+        std::string_view desc = "") {
+    return OptionSpec<T>{name, default_value, desc};
+}
+
+/**
+ * A set of options declared up front with their names, types and defaults.
+ * Names are indexed by a \ref PerfectHash built at compile time, e.g.
+ *
+ * @code
+ * constexpr auto kSchema = jfern::MakeSchema(
+ *     jfern::MakeOption<bool>("verbose", false, "Verbose output"),
+ *     jfern::MakeOption<double>("rate", 0.5),
+ *     jfern::MakeOption<std::string>("host", "localhost"));
+ *
+ * static_assert(kSchema.Valid(), "duplicate option names");
+ * @endcode
+ *
+ * @tparam Ts The types of each option
+ */
+template <typename... Ts>
+class Schema final {
+public:
+    /**
+     * The number of options in this schema
+     */
+    static constexpr std::size_t kSize = sizeof...(Ts);
+
+    /**
+     * The value returned by \ref Find() for an unknown name
+     */
+    static constexpr std::size_t npos = kSize;
+
+    constexpr explicit Schema(const OptionSpec<Ts>&... specs);
+
+    constexpr std::size_t Find(std::string_view name) const noexcept;
+
+    constexpr std::uint64_t Fingerprint() const noexcept;
+
+    template <std::size_t I>
+    constexpr const auto& Get() const noexcept;
+
+    constexpr std::string_view Name(std::size_t index) const noexcept;
+
+    template <typename Threading, typename... Us>
+    CmdLineError Register(BasicUserOptions<Threading, Us...>* options) const;
+
+    constexpr std::string_view Type(std::size_t index) const noexcept;
+
+    constexpr bool Valid() const noexcept;
+
+private:
+    static std::size_t Lookup(const void* schema,
+                              std::string_view name) noexcept;
+
+    template <typename Threading, typename... Us, std::size_t... Is>
+    CmdLineError Register_(BasicUserOptions<Threading, Us...>* options,
+                           std::index_sequence<Is...>) const;
+
+    template <typename T, typename Threading, typename... Us>
+    static CmdLineError Register_(const OptionSpec<T>& spec,
+                                  BasicUserOptions<Threading, Us...>* options);
+
+    /**
+     * The entries of this schema
+     */
+    std::tuple<OptionSpec<Ts>...> specs_;
+
+    /**
+     * Perfect hash over the option names
+     */
+    PerfectHash<kSize> hash_;
+};
+
+/**
+ * Create a schema from a list of entries
+ *
+ * @param[in] specs Entries created via \ref MakeOption()
+ *
+ * @return The schema
+ */
+template <typename... Ts>
+constexpr Schema<Ts...> MakeSchema(const OptionSpec<Ts>&... specs) {
+    return Schema<Ts...>(specs...);
+}
+
+/**
+ * Constructor
+ *
+ * @param[in] names The names to index. The backing characters must outlive
+ *                  this object
+ */
+template <std::size_t N>
+constexpr PerfectHash<N>::PerfectHash(
+        const std::array<std::string_view, N>& names)
+    : names_(names), seeds_(), slots_(), valid_(true) {
+    Build();
+}
+
+/**
+ * Look up a name
+ *
+ * @param[in] name The name to search for
+ *
+ * @return The index of this name in the array given to the constructor, or
+ *         \ref npos if not found
+ */
+template <std::size_t N>
+constexpr std::size_t PerfectHash<N>::Find(
+        std::string_view name) const noexcept {
+    const std::uint64_t hash = internal::HashName(name);
+    const std::int64_t seed = seeds_[hash & kMask];
+
+    const std::size_t slot =
+        seed < 0 ? static_cast<std::size_t>(-seed - 1)
+                 : internal::MixHash(hash, seed) & kMask;
+
+    const std::size_t index = slots_[slot];
+
+    return index != npos && names_[index] == name ? index : npos;
+}
+
+/**
+ * Check that every name was placed, i.e. there were no duplicates
+ *
+ * @return True if this table is usable
+ */
+template <std::size_t N>
+constexpr bool PerfectHash<N>::Valid() const noexcept {
+    return valid_;
+}
+
+/**
+ * Compute the bucket seeds and slot assignments
+ */
+template <std::size_t N>
+constexpr void PerfectHash<N>::Build() {
+    std::array<std::uint64_t, N> hashes{};
+    std::array<std::size_t, kTableSize + 1> start{};
+    std::array<std::size_t, N> members{};
+
+    for (std::size_t i = 0; i < kTableSize; i++) slots_[i] = npos;
+
+    /*
+     * Group the names by bucket, laid out contiguously in members
+     */
+    for (std::size_t i = 0; i < N; i++) {
+        hashes[i] = internal::HashName(names_[i]);
+        start[(hashes[i] & kMask) + 1]++;
+    }
+
+    std::size_t max_size = 0;
+    for (std::size_t b = 0; b < kTableSize; b++) {
+        if (start[b+1] > max_size) max_size = start[b+1];
+        start[b+1] += start[b];
+    }
+
+    std::array<std::size_t, kTableSize> fill{};
+    for (std::size_t i = 0; i < N; i++) {
+        const std::size_t b = hashes[i] & kMask;
+        members[start[b] + fill[b]++] = i;
+    }
+
+    /*
+     * Place the largest buckets first, while the table is still sparse
+     */
+    for (std::size_t size = max_size; size > 1; size--) {
+        for (std::size_t b = 0; b < kTableSize; b++) {
+            if (start[b+1] - start[b] != size) continue;
+
+            const std::size_t first = start[b];
+
+            for (std::size_t i = first; i < first + size; i++) {
+                for (std::size_t j = i + 1; j < first + size; j++) {
+                    if (hashes[members[i]] == hashes[members[j]]) {
+                        valid_ = false; return;
+                    }
+                }
+            }
+
+            std::int64_t seed = 1;
+            for (; seed < kMaxSeed; seed++) {
+                bool placed = true;
+
+                for (std::size_t i = first; placed && i < first + size; i++) {
+                    const std::size_t slot =
+                        internal::MixHash(hashes[members[i]], seed) & kMask;
+
+                    if (slots_[slot] != npos) {
+                        placed = false;
+                    } else {
+                        slots_[slot] = members[i];
+                    }
+                }
+
+                if (placed) break;
+
+                /*
+                 * Undo a partial placement
+                 */
+                for (std::size_t i = first; i < first + size; i++) {
+                    const std::size_t slot =
+                        internal::MixHash(hashes[members[i]], seed) & kMask;
+
+                    if (slots_[slot] == members[i]) slots_[slot] = npos;
+                }
+            }
+
+            if (seed == kMaxSeed) {
+                valid_ = false; return;
+            }
+
+            seeds_[b] = seed;
+        }
+    }
+
+    /*
+     * Single-name buckets point straight at any free slot
+     */
+    std::size_t free_slot = 0;
+    for (std::size_t b = 0; b < kTableSize; b++) {
+        if (start[b+1] - start[b] != 1) continue;
+
+        while (slots_[free_slot] != npos) free_slot++;
+
+        slots_[free_slot] = members[start[b]];
+        seeds_[b] = -static_cast<std::int64_t>(free_slot) - 1;
+    }
+}
+
+/**
+ * Constructor
+ *
+ * @param[in] specs The schema entries
+ */
+template <typename... Ts>
+constexpr Schema<Ts...>::Schema(const OptionSpec<Ts>&... specs)
+    : specs_(specs...),
+      hash_(std::array<std::string_view, kSize>{{specs.name...}}) {
+}
+
+/**
+ * Look up an option by name
+ *
+ * @param[in] name The option name
+ *
+ * @return The position of the option within this schema, or \ref npos
+ */
+template <typename... Ts>
+constexpr std::size_t Schema<Ts...>::Find(
+        std::string_view name) const noexcept {
+    return hash_.Find(name);
+}
+
+/**
+ * Hash the names and types of the options in this schema, in order, e.g.
+ * to check that a snapshot saved via BasicUserOptions::Save() was built
+ * from this schema. Defaults and descriptions are not included
+ *
+ * @return The fingerprint
+ */
+template <typename... Ts>
+constexpr std::uint64_t Schema<Ts...>::Fingerprint() const noexcept {
+    const std::array<std::string_view, kSize> names =
+        std::apply([](const auto&... spec) {
+            return std::array<std::string_view, kSize>{{spec.name...}};
+        }, specs_);
+
+    std::uint64_t hash = kSize;
+    for (std::size_t i = 0; i < kSize; i++) {
+        hash = internal::MixHash(hash ^ internal::HashName(names[i]),
+                                 internal::HashName(Type(i)));
+    }
+
+    return hash;
+}
+
+/**
+ * Get a schema entry
+ *
+ * @tparam I The position of the entry
+ *
+ * @return The entry
+ */
+template <typename... Ts>
+template <std::size_t I>
+constexpr const auto& Schema<Ts...>::Get() const noexcept {
+    return std::get<I>(specs_);
+}
+
+/**
+ * Get the name of an option
+ *
+ * @param[in] index The position of the option within this schema
+ *
+ * @return The option name
+ */
+template <typename... Ts>
+constexpr std::string_view Schema<Ts...>::Name(
+        std::size_t index) const noexcept {
+    const std::array<std::string_view, kSize> names =
+        std::apply([](const auto&... spec) {
+            return std::array<std::string_view, kSize>{{spec.name...}};
+        }, specs_);
+
+    return names[index];
+}
+
+/**
+ * Add every option in this schema to a set of user options, with its
+ * default value and description. From then on, the options resolve these
+ * names through a copy of this schema's perfect hash, so that parsing
+ * matches each --name with one hash and one compare. The copy views the
+ * same names, which must outlive the options, as string literals do
+ *
+ * @param[in] options The options to add to
+ *
+ * @return A \ref CmdLineError return code. Registration stops at the first
+ *         error
+ */
+template <typename... Ts>
+template <typename Threading, typename... Us>
+CmdLineError Schema<Ts...>::Register(
+        BasicUserOptions<Threading, Us...>* options) const {
+    if (!Valid()) return CmdLineError::kDuplicate;
+
+    const CmdLineError error =
+        Register_(options, std::index_sequence_for<Ts...>());
+
+    if (error != CmdLineError::kSuccess) return error;
+
+    const std::array<std::string_view, kSize> names =
+        std::apply([](const auto&... spec) {
+            return std::array<std::string_view, kSize>{{spec.name...}};
+        }, specs_);
+
+    options->BindSchema(
+        std::allocate_shared<Schema>(
+            std::pmr::polymorphic_allocator<Schema>(options->Resource()),
+            *this),
+        &Lookup, names.data(), kSize);
+
+    return CmdLineError::kSuccess;
+}
+
+/**
+ * Get the human-readable type of an option
+ *
+ * @param[in] index The position of the option within this schema
+ *
+ * @return The type name, as given by \ref internal::TypeToName
+ */
+template <typename... Ts>
+constexpr std::string_view Schema<Ts...>::Type(
+        std::size_t index) const noexcept {
+    constexpr std::array<std::string_view, kSize> types = {{
+        internal::TypeToName<Ts>::value...
+    }};
+
+    return types[index];
+}
+
+/**
+ * Check that the schema has no duplicate names
+ *
+ * @return True if the schema is usable
+ */
+template <typename... Ts>
+constexpr bool Schema<Ts...>::Valid() const noexcept {
+    return hash_.Valid();
+}
+
+/**
+ * Look up an option by name, for BasicUserOptions
+ *
+ * @param[in] schema The schema
+ * @param[in] name   The option name
+ *
+ * @return The position of the option within \a schema, or \ref npos
+ */
+template <typename... Ts>
+std::size_t Schema<Ts...>::Lookup(const void* schema,
+                                  std::string_view name) noexcept {
+    return static_cast<const Schema*>(schema)->Find(name);
+}
+
+/**
+ * Add each schema entry in turn
+ *
+ * @param[in] options The options to add to
+ *
+ * @return A \ref CmdLineError return code
+ */
+template <typename... Ts>
+template <typename Threading, typename... Us, std::size_t... Is>
+CmdLineError Schema<Ts...>::Register_(
+        BasicUserOptions<Threading, Us...>* options,
+        std::index_sequence<Is...>) const {
+    CmdLineError error = CmdLineError::kSuccess;
+
+    (void)((error = Register_(std::get<Is>(specs_), options),
+            error == CmdLineError::kSuccess) && ...);
+
+    return error;
+}
+
+/**
+ * Add a single schema entry
+ *
+ * @param[in] spec    The entry to add
+ * @param[in] options The options to add to
+ *
+ * @return A \ref CmdLineError return code
+ */
+template <typename... Ts>
+template <typename T, typename Threading, typename... Us>
+CmdLineError Schema<Ts...>::Register_(
+        const OptionSpec<T>& spec,
+        BasicUserOptions<Threading, Us...>* options) {
+    return options->template Add<T>(std::string(spec.name),
+                                     T(spec.default_value),
+                                     std::string(spec.description));
+}
+
+}  // namespace jfern
+
+#endif  // COMMAND_LINE_SCHEMA_H_
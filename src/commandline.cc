@@ -8,6 +8,31 @@
 
 #include "commandline/commandline.h"
 
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
 namespace jfern {
 namespace internal {
 constexpr char TypeToName<bool>::value[];
@@ -23,10 +48,1648 @@ constexpr char TypeToName<float>::value[];
 constexpr char TypeToName<double>::value[];
 constexpr char TypeToName<std::string>::value[];
 
-}  // namespace internal
+}  // namespace internal
+
+namespace {
+/**
+ * The option which asks \ref CommandLine::parse() to report how long each
+ * phase of startup took
+ */
+constexpr std::string_view kProfileName("cmdline_profile");
+
+/**
+ * A single command line argument split into an option name and value. Both
+ * views refer into the original argv entry; nothing is copied
+ */
+struct ArgToken {
+    std::string_view name;   ///< Option name, if \ref is_option
+    std::string_view value;  ///< Option value (or the entire argument)
+    bool is_option;          ///< True if the argument starts with "--"
+    bool has_equal;          ///< True if the value followed an "="
+};
+
+/**
+ * Scan a single command line argument in place. Leading and trailing
+ * whitespace is skipped, and the argument is split at the first "=" if it
+ * begins with "--"
+ *
+ * @param[in]  arg   The argument
+ * @param[in]  equal The offset of the first '=' in \a arg, or npos
+ * @param[out] token The scanned name and value
+ */
+void ScanArg(std::string_view arg, std::size_t equal, ArgToken* token) {
+    std::string_view str = internal::Trim(arg);
+
+    token->has_equal = false;
+    token->is_option = str.size() >= 2 && str[0] == '-' && str[1] == '-';
+
+    if (!token->is_option) {
+        token->name  = std::string_view();
+        token->value = str;
+        return;
+    }
+
+    str.remove_prefix(2);
+
+    // Neither whitespace nor "--" is an '=', so it can only be in str
+
+    if (equal != std::string_view::npos)
+        equal -= str.data() - arg.data();
+
+    if (equal == std::string_view::npos) {
+        token->name  = str;
+        token->value = str.substr(str.size());
+    } else {
+        token->name  = str.substr(0, equal);
+        token->value = str.substr(equal + 1);
+        token->has_equal = true;
+    }
+}
+
+/**
+ * Get the next line of a file
+ *
+ * @param[in]     contents The file contents
+ * @param[in]     index    The delimiters in \a contents
+ * @param[in,out] start    The offset of the line; advanced to the next
+ *
+ * @return The line, with surrounding whitespace (including any '\\r')
+ *         removed
+ */
+std::string_view NextLine(std::string_view contents,
+                          const internal::DelimiterIndex& index,
+                          std::size_t* start) {
+    std::size_t end = index.NextNewline(*start);
+    if (end == std::string_view::npos) end = contents.size();
+
+    const std::string_view line =
+        internal::Trim(contents.substr(*start, end - *start));
+
+    *start = end + 1;
+    return line;
+}
+
+/**
+ * Find the first '=' in a line
+ *
+ * @param[in] contents The file contents
+ * @param[in] index    The delimiters in \a contents
+ * @param[in] line     A line viewed within \a contents
+ *
+ * @return The offset of the '=' within \a line, or npos
+ */
+std::size_t FindEqual(std::string_view contents,
+                      const internal::DelimiterIndex& index,
+                      std::string_view line) {
+    const std::size_t offset = line.data() - contents.data();
+    const std::size_t equal  = index.NextEqual(offset, offset + line.size());
+
+    return equal == std::string_view::npos ? equal : equal - offset;
+}
+
+/**
+ * Check whether a config file line continues with a comment, or nothing
+ *
+ * @param[in] rest The rest of the line
+ *
+ * @return True if \a rest is blank or starts with '#' or ';'
+ */
+bool IsComment(std::string_view rest) {
+    rest = internal::Trim(rest);
+    return rest.empty() || rest.front() == '#' || rest.front() == ';';
+}
+
+/**
+ * Get the value from the text after the '=' of a config file line. A value
+ * in single or double quotes ends at the closing quote, and the quotes are
+ * removed. Otherwise the value ends at a '#' or ';' which starts the text
+ * or follows whitespace; the rest of the line is a comment
+ *
+ * @param[in] text The text after the '='
+ *
+ * @return The value
+ */
+std::string_view ConfigValue(std::string_view text) {
+    text = internal::Trim(text);
+
+    if (!text.empty() && (text.front() == '"' || text.front() == '\'')) {
+        const std::size_t close = text.find(text.front(), 1);
+
+        if (close != std::string_view::npos &&
+            IsComment(text.substr(close + 1))) {
+            return text.substr(1, close - 1);
+        }
+
+        return text;
+    }
+
+    for (std::size_t i = 0; i < text.size(); i++) {
+        if ((text[i] == '#' || text[i] == ';') &&
+            (i == 0 || text[i - 1] == ' ' || text[i - 1] == '\t')) {
+            return internal::Trim(text.substr(0, i));
+        }
+    }
+
+    return text;
+}
+
+}  // namespace
+
+namespace internal {
+/**
+ * Move constructor
+ *
+ * @param[in] file The mapping to take ownership of
+ */
+MappedFile::MappedFile(MappedFile&& file) noexcept
+    : data_(file.data_), size_(file.size_) {
+    file.data_ = nullptr;
+    file.size_ = 0;
+}
+
+/**
+ * Move assignment operator
+ *
+ * @param[in] file The mapping to take ownership of
+ *
+ * @return *this
+ */
+MappedFile& MappedFile::operator=(MappedFile&& file) noexcept {
+    if (this != &file) {
+        Close();
+        data_ = file.data_;
+        size_ = file.size_;
+        file.data_ = nullptr;
+        file.size_ = 0;
+    }
+
+    return *this;
+}
+
+/**
+ * Destructor. Unmaps the file
+ */
+MappedFile::~MappedFile() {
+    Close();
+}
+
+/**
+ * Get the contents of the file
+ *
+ * @return A view of the mapped bytes
+ */
+std::string_view MappedFile::Contents() const noexcept {
+    return std::string_view(data_, size_);
+}
+
+/**
+ * Map a file into memory, replacing any previous mapping
+ *
+ * @param[in] path The file to map
+ *
+ * @return True on success
+ */
+bool MappedFile::Open(const std::string& path) {
+    Close();
+
+#if defined(_WIN32)
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream) return false;
+
+    const std::streamoff size = stream.tellg();
+    if (size <= 0) return size == 0;
+
+    char* data = new char[static_cast<std::size_t>(size)];
+    stream.seekg(0);
+
+    if (!stream.read(data, size)) {
+        delete[] data; return false;
+    }
+
+    data_ = data;
+    size_ = static_cast<std::size_t>(size);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd); return false;
+    }
+
+    /*
+     * An empty file cannot be mapped, but is a valid (empty) response file
+     */
+    if (info.st_size > 0) {
+        void* data = ::mmap(nullptr, static_cast<std::size_t>(info.st_size),
+                            PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data == MAP_FAILED) {
+            ::close(fd); return false;
+        }
+
+        data_ = static_cast<const char*>(data);
+        size_ = static_cast<std::size_t>(info.st_size);
+    }
+
+    ::close(fd);
+#endif
+
+    return true;
+}
+
+/**
+ * Release the mapping, if any
+ */
+void MappedFile::Close() noexcept {
+    if (data_ != nullptr) {
+#if defined(_WIN32)
+        delete[] data_;
+#else
+        ::munmap(const_cast<char*>(data_), size_);
+#endif
+    }
+
+    data_ = nullptr;
+    size_ = 0;
+}
+
+/**
+ * Default constructor. Allocates from the default memory resource
+ */
+StringArena::StringArena()
+    : StringArena(std::pmr::get_default_resource()) {
+}
+
+/**
+ * Constructor
+ *
+ * @param[in] resource The memory resource to allocate from
+ */
+StringArena::StringArena(std::pmr::memory_resource* resource)
+    : resource_(resource), blocks_(resource), table_(resource) {
+}
+
+/**
+ * Copy constructor. The copy shares the blocks written so far but starts a
+ * new block for its own strings, from the same memory resource
+ *
+ * @param[in] arena The arena to copy
+ */
+StringArena::StringArena(const StringArena& arena)
+    : resource_(arena.resource_), blocks_(arena.blocks_, arena.resource_),
+      next_(nullptr), remaining_(0), block_size_(0),
+      table_(arena.table_, arena.resource_), count_(arena.count_) {
+}
+
+/**
+ * Move constructor
+ *
+ * @param[in] arena The arena to take the strings of
+ */
+StringArena::StringArena(StringArena&& arena) noexcept
+    : resource_(arena.resource_), blocks_(std::move(arena.blocks_)),
+      next_(arena.next_),
+      remaining_(arena.remaining_), block_size_(arena.block_size_),
+      table_(std::move(arena.table_)), count_(arena.count_) {
+    arena.next_       = nullptr;
+    arena.remaining_  = 0;
+    arena.block_size_ = 0;
+    arena.count_      = 0;
+    arena.table_.clear();
+}
+
+/**
+ * Copy assignment operator. This arena keeps its own memory resource. If
+ * the other arena allocates from the same one, their blocks are shared as
+ * by the copy constructor; otherwise each string is copied into this
+ * arena, so that none of them depends on the other resource
+ *
+ * @param[in] arena The arena to copy
+ *
+ * @return *this
+ */
+StringArena& StringArena::operator=(const StringArena& arena) {
+    if (this == &arena) return *this;
+
+    if (resource_->is_equal(*arena.resource_)) {
+        *this = StringArena(arena);
+        return *this;
+    }
+
+    StringArena copy(resource_);
+    copy.Reserve(arena.count_);
+
+    for (std::string_view str : arena.table_) {
+        if (str.data() != nullptr) copy.Intern(str);
+    }
+
+    *this = std::move(copy);
+
+    return *this;
+}
+
+/**
+ * Move assignment operator. This arena keeps its own memory resource. The
+ * blocks of an arena using the same resource are taken; those of one using
+ * another resource cannot change hands, so its strings are copied instead
+ *
+ * @param[in] arena The arena to take the strings of
+ *
+ * @return *this
+ */
+StringArena& StringArena::operator=(StringArena&& arena) {
+    if (this == &arena) return *this;
+
+    if (!resource_->is_equal(*arena.resource_))
+        return *this = static_cast<const StringArena&>(arena);
+
+    blocks_     = std::move(arena.blocks_);
+    next_       = arena.next_;
+    remaining_  = arena.remaining_;
+    block_size_ = arena.block_size_;
+    table_      = std::move(arena.table_);
+    count_      = arena.count_;
+
+    arena.next_       = nullptr;
+    arena.remaining_  = 0;
+    arena.block_size_ = 0;
+    arena.count_      = 0;
+    arena.table_.clear();
+
+    return *this;
+}
+
+/**
+ * Take shared ownership of memory holding strings, which can then be
+ * interned in place via \ref InternStored()
+ *
+ * @param[in] block The memory
+ */
+void StringArena::Adopt(std::shared_ptr<char[]> block) {
+    blocks_.push_back(std::move(block));
+}
+
+/**
+ * Get the stored copy of a string, storing it first if this is the first
+ * time it has been seen
+ *
+ * @param[in] str The string
+ *
+ * @return A view of the stored copy, which lives as long as this arena or
+ *         any copy of it
+ */
+std::string_view StringArena::Intern(std::string_view str) {
+    return Insert(str, true);
+}
+
+/**
+ * Like \ref Intern(), for a string already held by a block given to
+ * \ref Adopt(). The first time the string is seen, it is recorded where it
+ * lies rather than copied
+ *
+ * @param[in] str The string, within an adopted block
+ *
+ * @return A view of the stored string
+ */
+std::string_view StringArena::InternStored(std::string_view str) {
+    return Insert(str, false);
+}
+
+/**
+ * Look up a string, adding it if this is the first time it has been seen
+ *
+ * @param[in] str  The string
+ * @param[in] copy True to copy a new string into this arena's blocks
+ *
+ * @return A view of the stored string
+ */
+std::string_view StringArena::Insert(std::string_view str, bool copy) {
+    if (str.empty()) return std::string_view();
+
+    if (2 * (count_ + 1) > table_.size())
+        Rehash(std::max<std::size_t>(16, 2 * table_.size()));
+
+    const std::size_t mask = table_.size() - 1;
+
+    std::size_t slot = std::hash<std::string_view>()(str) & mask;
+    while (table_[slot].data() != nullptr) {
+        if (table_[slot] == str) return table_[slot];
+        slot = (slot + 1) & mask;
+    }
+
+    if (copy) {
+        char* data = Allocate(str.size());
+        std::copy(str.begin(), str.end(), data);
+
+        str = std::string_view(data, str.size());
+    }
+
+    table_[slot] = str;
+    count_++;
+
+    return table_[slot];
+}
+
+/**
+ * Reserve space for a string
+ *
+ * @param[in] size The number of bytes
+ *
+ * @return The reserved space
+ */
+char* StringArena::Allocate(std::size_t size) {
+    if (size > kMaxBlockSize / 4)
+        return AllocateBlock(size);
+
+    if (size > remaining_) {
+        block_size_ = std::min(kMaxBlockSize,
+                               std::max(kMinBlockSize, 2 * block_size_));
+        while (block_size_ < size) block_size_ *= 2;
+
+        next_      = AllocateBlock(block_size_);
+        remaining_ = block_size_;
+    }
+
+    char* result = next_;
+    next_      += size;
+    remaining_ -= size;
+
+    return result;
+}
+
+/**
+ * Allocate a new block from the memory resource. The block is returned to
+ * the resource once neither this arena nor any copy of it refers to it
+ *
+ * @param[in] size The size of the block
+ *
+ * @return The block
+ */
+char* StringArena::AllocateBlock(std::size_t size) {
+    std::pmr::memory_resource* resource = resource_;
+
+    auto release = [resource, size](char* block) {
+        resource->deallocate(block, size, 1);
+    };
+
+    std::shared_ptr<char[]> block(
+        static_cast<char*>(resource->allocate(size, 1)), release,
+        std::pmr::polymorphic_allocator<char>(resource));
+
+    blocks_.push_back(std::move(block));
+
+    return blocks_.back().get();
+}
+
+/**
+ * Make room for more strings, so that storing them does not resize the
+ * hash table
+ *
+ * @param[in] count The number of strings that will be stored
+ */
+void StringArena::Reserve(std::size_t count) {
+    std::size_t size = std::max<std::size_t>(16, table_.size());
+    while (size < 2 * (count_ + count)) size *= 2;
+
+    if (size > table_.size()) Rehash(size);
+}
+
+/**
+ * Resize the hash table
+ *
+ * @param[in] size The new size, a power of two
+ */
+void StringArena::Rehash(std::size_t size) {
+    std::pmr::vector<std::string_view> table(size, resource_);
+
+    const std::size_t mask = table.size() - 1;
+
+    for (std::string_view str : table_) {
+        if (str.data() == nullptr) continue;
+
+        std::size_t slot = std::hash<std::string_view>()(str) & mask;
+        while (table[slot].data() != nullptr) slot = (slot + 1) & mask;
+
+        table[slot] = str;
+    }
+
+    table_ = std::move(table);
+}
+
+/**
+ * Default constructor. Allocates from the default memory resource
+ */
+PrefixIndex::PrefixIndex()
+    : PrefixIndex(std::pmr::get_default_resource()) {
+}
+
+/**
+ * Constructor
+ *
+ * @param[in] resource The memory resource to allocate from
+ */
+PrefixIndex::PrefixIndex(std::pmr::memory_resource* resource)
+    : nodes_(resource), free_(resource) {
+    nodes_.push_back({std::string_view(), kNone, kNone, false});
+}
+
+/**
+ * List every name beginning with a prefix. This takes time proportional
+ * to the length of the prefix plus the number of names listed
+ *
+ * @param[in]  prefix The prefix, or empty for every name
+ * @param[out] names  The names, in sorted order, are appended to this
+ */
+void PrefixIndex::Collect(std::string_view prefix,
+                          std::pmr::vector<std::string_view>* names) const {
+    std::uint32_t node = 0;
+    std::size_t   pos  = 0;
+
+    while (pos < prefix.size()) {
+        node = Child(node, prefix[pos]);
+        if (node == kNone) return;
+
+        const std::string_view label = nodes_[node].label;
+        const std::string_view rest  = prefix.substr(pos);
+
+        // The prefix may end partway along this edge
+
+        const std::size_t size = std::min(label.size(), rest.size());
+        if (label.compare(0, size, rest, 0, size) != 0) return;
+
+        pos += label.size();
+    }
+
+    Collect_(node, pos, names);
+}
+
+/**
+ * Remove a name. A node left with a single child is merged with it, so the
+ * tree stays as compact as if the name had never been inserted
+ *
+ * @param[in] name The name to remove
+ */
+void PrefixIndex::Erase(std::string_view name) {
+    std::uint32_t parent = kNone;
+    std::uint32_t node   = 0;
+    std::size_t   pos    = 0;
+
+    while (pos < name.size()) {
+        const std::uint32_t child = Child(node, name[pos]);
+        if (child == kNone) return;
+
+        const std::string_view label = nodes_[child].label;
+        if (name.compare(pos, label.size(), label) != 0) return;
+
+        parent = node;
+        node   = child;
+        pos   += label.size();
+    }
+
+    if (node == 0 || !nodes_[node].terminal) return;
+
+    nodes_[node].terminal = false;
+
+    if (nodes_[node].first_child == kNone) {
+        Unlink(parent, node);
+        Free(node);
+
+        node = parent;
+    }
+
+    if (node != 0 && !nodes_[node].terminal) Merge(node);
+}
+
+/**
+ * Make room for more names, so that inserting them does not reallocate.
+ * Each name adds at most two nodes
+ *
+ * @param[in] count The number of names that will be inserted
+ */
+void PrefixIndex::Reserve(std::size_t count) {
+    internal::ReserveMore(2 * count, &nodes_);
+}
+
+/**
+ * Add a name. Adding a name already present has no effect
+ *
+ * @param[in] name The name, which must outlive this index or its removal
+ */
+void PrefixIndex::Insert(std::string_view name) {
+    std::uint32_t node = 0;
+    std::size_t   pos  = 0;
+
+    while (pos < name.size()) {
+        const std::uint32_t child = Child(node, name[pos]);
+
+        if (child == kNone) {
+            Link(node, NewNode(name.substr(pos), true));
+            return;
+        }
+
+        const std::string_view label = nodes_[child].label;
+
+        std::size_t common = 1;
+        while (common < label.size() && pos + common < name.size() &&
+               label[common] == name[pos + common]) {
+            common++;
+        }
+
+        if (common < label.size()) {
+            /*
+             * Split the edge, putting a new node where the name diverges
+             * from (or ends partway along) the label
+             */
+            const std::uint32_t middle = NewNode(label.substr(0, common),
+                                                 false);
+            Unlink(node, child);
+
+            nodes_[child].label = label.substr(common);
+            nodes_[middle].first_child = child;
+
+            Link(node, middle);
+            node = middle;
+        } else {
+            node = child;
+        }
+
+        pos += common;
+    }
+
+    // A terminal node's label must be a tail of its own name
+
+    const std::size_t size = nodes_[node].label.size();
+
+    nodes_[node].label    = name.substr(name.size() - size);
+    nodes_[node].terminal = true;
+}
+
+/**
+ * Find the child of a node whose label begins with a character
+ *
+ * @param[in] node The parent
+ * @param[in] c    The first character of the label
+ *
+ * @return The child, or kNone if there is none
+ */
+std::uint32_t PrefixIndex::Child(std::uint32_t node, char c) const noexcept {
+    const auto key = static_cast<unsigned char>(c);
+
+    for (std::uint32_t child = nodes_[node].first_child; child != kNone;
+         child = nodes_[child].next_sibling) {
+        const auto first =
+            static_cast<unsigned char>(nodes_[child].label[0]);
+
+        if (first == key) return child;
+        if (first >  key) break;
+    }
+
+    return kNone;
+}
+
+/**
+ * List every name at or below a node, in sorted order
+ *
+ * @param[in]  node  The node
+ * @param[in]  depth The length of the key leading to, and including, the
+ *                   node's label
+ * @param[out] names The names are appended to this
+ */
+void PrefixIndex::Collect_(std::uint32_t node,
+                           std::size_t depth,
+                           std::pmr::vector<std::string_view>* names) const {
+    const Node& current = nodes_[node];
+
+    if (current.terminal) {
+        const char* end = current.label.data() + current.label.size();
+        names->emplace_back(end - depth, depth);
+    }
+
+    for (std::uint32_t child = current.first_child; child != kNone;
+         child = nodes_[child].next_sibling) {
+        Collect_(child, depth + nodes_[child].label.size(), names);
+    }
+}
+
+/**
+ * Merge a node with its child if it has exactly one. Every label is a view
+ * of a name in which it is preceded by the labels above it, so the merged
+ * label is the child's label extended backwards
+ *
+ * @param[in] node The node
+ */
+void PrefixIndex::Merge(std::uint32_t node) {
+    const std::uint32_t child = nodes_[node].first_child;
+
+    if (child == kNone || nodes_[child].next_sibling != kNone) return;
+
+    const std::string_view label = nodes_[child].label;
+    const std::size_t size = nodes_[node].label.size() + label.size();
+
+    nodes_[node].label = std::string_view(label.data() + label.size() - size,
+                                          size);
+    nodes_[node].terminal    = nodes_[child].terminal;
+    nodes_[node].first_child = nodes_[child].first_child;
+
+    Free(child);
+}
+
+/**
+ * Return a node to the free list
+ *
+ * @param[in] node The node, which must already be unlinked
+ */
+void PrefixIndex::Free(std::uint32_t node) {
+    nodes_[node] = {std::string_view(), kNone, kNone, false};
+    free_.push_back(node);
+}
+
+/**
+ * Create a node with no children
+ *
+ * @param[in] label    The edge into the node
+ * @param[in] terminal True if a name ends at the node
+ *
+ * @return The new node
+ */
+std::uint32_t PrefixIndex::NewNode(std::string_view label, bool terminal) {
+    const Node node = {label, kNone, kNone, terminal};
+
+    if (!free_.empty()) {
+        const std::uint32_t index = free_.back();
+        free_.pop_back();
+
+        nodes_[index] = node;
+        return index;
+    }
+
+    nodes_.push_back(node);
+    return static_cast<std::uint32_t>(nodes_.size() - 1);
+}
+
+/**
+ * Add a child to a node, keeping the children sorted by label
+ *
+ * @param[in] parent The parent
+ * @param[in] child  The child, which must not already be linked
+ */
+void PrefixIndex::Link(std::uint32_t parent, std::uint32_t child) {
+    const auto first = static_cast<unsigned char>(nodes_[child].label[0]);
+
+    std::uint32_t* link = &nodes_[parent].first_child;
+
+    while (*link != kNone &&
+           static_cast<unsigned char>(nodes_[*link].label[0]) < first) {
+        link = &nodes_[*link].next_sibling;
+    }
+
+    nodes_[child].next_sibling = *link;
+    *link = child;
+}
+
+/**
+ * Remove a child from a node
+ *
+ * @param[in] parent The parent
+ * @param[in] child  The child
+ */
+void PrefixIndex::Unlink(std::uint32_t parent, std::uint32_t child) {
+    std::uint32_t* link = &nodes_[parent].first_child;
+
+    while (*link != child)
+        link = &nodes_[*link].next_sibling;
+
+    *link = nodes_[child].next_sibling;
+    nodes_[child].next_sibling = kNone;
+}
+
+namespace {
+/**
+ * Count the trailing zero bits of a word
+ *
+ * @param[in] word The word, which must not be zero
+ *
+ * @return The index of the lowest set bit
+ */
+std::size_t CountTrailingZeros(std::uint64_t word) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<std::size_t>(__builtin_ctzll(word));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return index;
+#else
+    std::size_t count = 0;
+    for (; (word & 1) == 0; word >>= 1) count++;
+    return count;
+#endif
+}
+
+/**
+ * Mark the newlines and equals signs in 64 bytes of text, one byte at a
+ * time
+ *
+ * @param[in]  data     The text
+ * @param[in]  size     The number of bytes, at most 64
+ * @param[out] equals   Bit i is set if data[i] is an '='
+ * @param[out] newlines Bit i is set if data[i] is a '\\n'
+ */
+void ScanBlockScalar(const char* data, std::size_t size,
+                     std::uint64_t* equals, std::uint64_t* newlines) {
+    std::uint64_t equal_bits = 0, newline_bits = 0;
+
+    for (std::size_t i = 0; i < size; i++) {
+        equal_bits   |= std::uint64_t(data[i] == '=')  << i;
+        newline_bits |= std::uint64_t(data[i] == '\n') << i;
+    }
+
+    *equals   = equal_bits;
+    *newlines = newline_bits;
+}
+
+/**
+ * Mark the newlines and equals signs in exactly 64 bytes of text, using
+ * vector compares where available
+ *
+ * @see ScanBlockScalar
+ */
+void ScanBlockSimd(const char* data,
+                   std::uint64_t* equals, std::uint64_t* newlines) {
+#if defined(__AVX2__)
+    const __m256i equal   = _mm256_set1_epi8('=');
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    const __m256i lo = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(data));
+    const __m256i hi = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(data + 32));
+
+    auto mask = [](__m256i lo, __m256i hi, __m256i c) {
+        const std::uint32_t lo_bits = static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, c)));
+        const std::uint32_t hi_bits = static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, c)));
+
+        return (std::uint64_t(hi_bits) << 32) | lo_bits;
+    };
+
+    *equals   = mask(lo, hi, equal);
+    *newlines = mask(lo, hi, newline);
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128i equal   = _mm_set1_epi8('=');
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    std::uint64_t equal_bits = 0, newline_bits = 0;
+
+    for (int i = 0; i < 4; i++) {
+        const __m128i chunk = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(data + 16 * i));
+
+        const std::uint64_t equal_chunk = static_cast<std::uint16_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, equal)));
+        const std::uint64_t newline_chunk = static_cast<std::uint16_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+
+        equal_bits   |= equal_chunk   << (16 * i);
+        newline_bits |= newline_chunk << (16 * i);
+    }
+
+    *equals   = equal_bits;
+    *newlines = newline_bits;
+#else
+    ScanBlockScalar(data, 64, equals, newlines);
+#endif
+}
+
+}  // namespace
+
+/**
+ * Constructor. Builds the bitmaps
+ *
+ * @param[in] text     The text to index
+ * @param[in] mode     Whether to use vector instructions. If none are
+ *                     available, kSimd behaves like kScalar
+ * @param[in] resource The memory resource for the bitmaps
+ */
+DelimiterIndex::DelimiterIndex(std::string_view text, Mode mode,
+                               std::pmr::memory_resource* resource)
+    : equals_((text.size() + 63) / 64, resource),
+      newlines_(equals_.size(), resource) {
+    const std::size_t blocks = text.size() / 64;
+
+    for (std::size_t i = 0; i < blocks; i++) {
+        const char* block = text.data() + 64 * i;
+
+        if (mode == Mode::kSimd)
+            ScanBlockSimd(block, &equals_[i], &newlines_[i]);
+        else
+            ScanBlockScalar(block, 64, &equals_[i], &newlines_[i]);
+    }
+
+    if (const std::size_t rest = text.size() % 64) {
+        ScanBlockScalar(text.data() + 64 * blocks, rest,
+                        &equals_[blocks], &newlines_[blocks]);
+    }
+}
+
+/**
+ * Find the next '=' within a range
+ *
+ * @param[in] pos The offset at which to start searching
+ * @param[in] end The offset at which to stop
+ *
+ * @return The offset of the '=', or npos if there is none before \a end
+ */
+std::size_t DelimiterIndex::NextEqual(std::size_t pos,
+                                      std::size_t end) const noexcept {
+    return Next(equals_, pos, end);
+}
+
+/**
+ * Find the next '\\n'
+ *
+ * @param[in] pos The offset at which to start searching
+ *
+ * @return The offset of the newline, or npos if there is none
+ */
+std::size_t DelimiterIndex::NextNewline(std::size_t pos) const noexcept {
+    return Next(newlines_, pos, 64 * newlines_.size());
+}
+
+/**
+ * Get the vector instruction set used by Mode::kSimd
+ *
+ * @return "AVX2", "SSE2" or "none"
+ */
+const char* DelimiterIndex::SimdName() noexcept {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__) || defined(_M_X64)
+    return "SSE2";
+#else
+    return "none";
+#endif
+}
+
+/**
+ * Find the next set bit within a range
+ *
+ * @param[in] bits The bitmap to search
+ * @param[in] pos  The bit at which to start searching
+ * @param[in] end  The bit at which to stop
+ *
+ * @return The index of the set bit, or npos if there is none before
+ *         \a end
+ */
+std::size_t DelimiterIndex::Next(const std::pmr::vector<std::uint64_t>& bits,
+                                 std::size_t pos,
+                                 std::size_t end) noexcept {
+    end = std::min(end, 64 * bits.size());
+    if (pos >= end) return std::string_view::npos;
+
+    std::size_t word = pos / 64;
+    const std::size_t last = (end - 1) / 64;
+
+    std::uint64_t mask = bits[word] & (~std::uint64_t(0) << (pos % 64));
+
+    while (mask == 0) {
+        if (++word > last) return std::string_view::npos;
+        mask = bits[word];
+    }
+
+    const std::size_t found = 64 * word + CountTrailingZeros(mask);
+
+    return found < end ? found : std::string_view::npos;
+}
+
+}  // namespace internal
+
+/**
+ * Default constructor. Allocations are forwarded to the default memory
+ * resource
+ */
+StartupProfile::StartupProfile()
+    : StartupProfile(std::pmr::get_default_resource()) {
+}
+
+/**
+ * Constructor
+ *
+ * @param[in] upstream The memory resource to forward allocations to
+ */
+StartupProfile::StartupProfile(std::pmr::memory_resource* upstream)
+    : upstream_(upstream), counters_() {
+}
+
+/**
+ * Get what was recorded for a phase
+ *
+ * @param[in] phase The phase
+ *
+ * @return The phase's counters
+ */
+auto StartupProfile::Get(Phase phase) const noexcept -> const Counters& {
+    return counters_[static_cast<std::size_t>(phase)];
+}
+
+/**
+ * Get the name of a phase, as it appears in \ref Report()
+ *
+ * @param[in] phase The phase
+ *
+ * @return The name
+ */
+const char* StartupProfile::Name(Phase phase) noexcept {
+    switch (phase) {
+      case Phase::kRegister: return "register";
+      case Phase::kTokenize: return "tokenize";
+      case Phase::kResolve:  return "resolve";
+      case Phase::kConvert:  return "convert";
+      case Phase::kAssign:   return "assign";
+    }
+
+    return "unknown";
+}
+
+/**
+ * Write a table of what was recorded, one phase per line followed by the
+ * total. Times are in microseconds
+ *
+ * @param[in] os The stream to write to
+ */
+void StartupProfile::Report(std::ostream& os) const {
+    std::string output(
+        "phase          calls     time (us)      allocs         bytes\n");
+
+    auto append = [&output](const char* name, const Counters& counters) {
+        char line[96];
+        const int size = std::snprintf(
+            line, sizeof(line), "%-9s %10llu %13.3f %11llu %13llu\n",
+            name,
+            static_cast<unsigned long long>(counters.calls),
+            static_cast<double>(counters.nanoseconds) / 1000.0,
+            static_cast<unsigned long long>(counters.allocations),
+            static_cast<unsigned long long>(counters.bytes));
+
+        if (size > 0)
+            output.append(line, std::min<std::size_t>(size, sizeof(line) - 1));
+    };
+
+    Counters total;
+    for (std::size_t i = 0; i < kPhases; i++) {
+        const Counters& counters = counters_[i];
+        append(Name(static_cast<Phase>(i)), counters);
+
+        total.calls       += counters.calls;
+        total.nanoseconds += counters.nanoseconds;
+        total.allocations += counters.allocations;
+        total.bytes       += counters.bytes;
+    }
+
+    append("total", total);
+
+    os.write(output.data(), static_cast<std::streamsize>(output.size()));
+}
+
+/**
+ * Clear everything recorded so far
+ */
+void StartupProfile::Reset() noexcept {
+    for (Counters& counters : counters_)
+        counters = Counters();
+}
+
+/**
+ * Allocate from the upstream resource, charging the allocation to the phase
+ * being timed, if any
+ *
+ * @param[in] bytes     The size of the allocation
+ * @param[in] alignment The alignment of the allocation
+ *
+ * @return The allocated memory
+ */
+void* StartupProfile::do_allocate(std::size_t bytes, std::size_t alignment) {
+    if (active_ != kIdle) {
+        counters_[active_].allocations++;
+        counters_[active_].bytes += bytes;
+    }
+
+    return upstream_->allocate(bytes, alignment);
+}
+
+/**
+ * Return memory to the upstream resource
+ *
+ * @param[in] p         The memory
+ * @param[in] bytes     The size it was allocated with
+ * @param[in] alignment The alignment it was allocated with
+ */
+void StartupProfile::do_deallocate(void* p,
+                                   std::size_t bytes,
+                                   std::size_t alignment) {
+    upstream_->deallocate(p, bytes, alignment);
+}
+
+/**
+ * Check whether memory from this resource can be freed by another
+ *
+ * @param[in] other The other resource
+ *
+ * @return True only if \a other is this profile
+ */
+bool StartupProfile::do_is_equal(const std::pmr::memory_resource& other)
+    const noexcept {
+    return this == &other;
+}
+
+/**
+ * Default constructor. Allocates from the default memory resource
+ */
+ParsedArgs::ParsedArgs()
+    : ParsedArgs(std::pmr::get_default_resource()) {
+}
+
+/**
+ * Constructor
+ *
+ * @param[in] resource The memory resource to allocate from
+ */
+ParsedArgs::ParsedArgs(std::pmr::memory_resource* resource)
+    : pairs_(resource), joined_(resource), files_(resource) {
+}
+
+/**
+ * Move assignment. If the two objects allocate from different memory
+ * resources, the owned names and values are copied into this object's
+ * resource, since the strings cannot change hands, and the pairs viewing
+ * them are pointed at the copies. Mapped files keep their address
+ *
+ * @param[in] args The pairs to take
+ *
+ * @return *this
+ */
+ParsedArgs& ParsedArgs::operator=(ParsedArgs&& args) {
+    if (this == &args) return *this;
+
+    if (Resource()->is_equal(*args.Resource())) {
+        pairs_  = std::move(args.pairs_);
+        joined_ = std::move(args.joined_);
+        files_  = std::move(args.files_);
+
+        return *this;
+    }
+
+    clear();
+
+    files_ = std::move(args.files_);
+    pairs_.assign(args.pairs_.begin(), args.pairs_.end());
+
+    // Owned storage is always viewed whole, so its address identifies it
+
+    std::pmr::unordered_map<const char*, std::string_view> copies(
+        Resource());
+    copies.reserve(args.joined_.size());
+
+    for (const std::pmr::string& str : args.joined_) {
+        joined_.emplace_back(str);
+        copies.emplace(str.data(), joined_.back());
+    }
+
+    for (value_type& pair : pairs_) {
+        for (std::string_view* view : { &pair.first, &pair.second }) {
+            auto iter = copies.find(view->data());
+            if (iter != copies.end()) *view = iter->second;
+        }
+    }
+
+    args.clear();
+
+    return *this;
+}
+
+/**
+ * Get an iterator to the first option, value pair
+ *
+ * @return The beginning of the sorted pairs
+ */
+ParsedArgs::const_iterator ParsedArgs::begin() const noexcept {
+    return pairs_.begin();
+}
+
+/**
+ * Remove all option, value pairs
+ */
+void ParsedArgs::clear() noexcept {
+    pairs_.clear();
+    joined_.clear();
+    files_.clear();
+}
+
+/**
+ * Check if no options were parsed
+ *
+ * @return True if there are no option, value pairs
+ */
+bool ParsedArgs::empty() const noexcept {
+    return pairs_.empty();
+}
+
+/**
+ * Get an iterator past the last option, value pair
+ *
+ * @return The end of the sorted pairs
+ */
+ParsedArgs::const_iterator ParsedArgs::end() const noexcept {
+    return pairs_.end();
+}
+
+/**
+ * Look up the value of an option by binary search
+ *
+ * @param[in] name The option name
+ *
+ * @return An iterator to the pair, or \ref end() if not found
+ */
+ParsedArgs::const_iterator ParsedArgs::Find(std::string_view name) const {
+    auto iter = std::lower_bound(pairs_.begin(), pairs_.end(), name,
+        [](const value_type& pair, std::string_view key) {
+            return pair.first < key;
+        });
+
+    if (iter != pairs_.end() && iter->first == name) return iter;
+
+    return pairs_.end();
+}
+
+/**
+ * Get the number of option, value pairs
+ *
+ * @return The number of unique options parsed
+ */
+std::size_t ParsedArgs::size() const noexcept {
+    return pairs_.size();
+}
+
+/**
+ * Record a new option, value pair
+ *
+ * @param[in] name  The option name
+ * @param[in] value Its value
+ */
+void ParsedArgs::Append(std::string_view name, std::string_view value) {
+    pairs_.emplace_back(name, value);
+}
+
+/**
+ * Record a new option, value pair whose name is not backed by the command
+ * line or a mapped file
+ *
+ * @param[in] name  The option name, which this object takes ownership of
+ * @param[in] value Its value
+ */
+void ParsedArgs::Append(std::pmr::string&& name, std::string_view value) {
+    joined_.push_back(std::move(name));
+    pairs_.emplace_back(joined_.back(), value);
+}
+
+/**
+ * Extend the value of the most recent option with another argument,
+ * separated by a space. The joined value is moved into owned storage
+ *
+ * @param[in] value The argument to append
+ */
+void ParsedArgs::Continue(std::string_view value) {
+    std::string_view& current = pairs_.back().second;
+
+    if (current.empty()) {
+        current = value; return;
+    }
+
+    if (joined_.empty() || joined_.back().data() != current.data())
+        joined_.emplace_back(current);
+
+    std::pmr::string& storage = joined_.back();
+    storage.push_back(' ');
+    storage.append(value);
+
+    current = storage;
+}
+
+/**
+ * Sort the pairs by name. If an option was given more than once, the last
+ * occurrence wins
+ */
+void ParsedArgs::Finalize() {
+    std::stable_sort(pairs_.begin(), pairs_.end(),
+        [](const value_type& pair1, const value_type& pair2) {
+            return pair1.first < pair2.first;
+        });
+
+    auto out = pairs_.begin();
+    for (auto iter = pairs_.begin(); iter != pairs_.end(); ++iter) {
+        auto next = iter + 1;
+        if (next != pairs_.end() && next->first == iter->first) continue;
+
+        *out++ = *iter;
+    }
+
+    pairs_.erase(out, pairs_.end());
+}
+
+/**
+ * Get the memory resource from which this object allocates
+ *
+ * @return The memory resource
+ */
+std::pmr::memory_resource* ParsedArgs::Resource() const noexcept {
+    return pairs_.get_allocator().resource();
+}
+
+/**
+ * Holds notifications from the options for as long as it is in scope. If
+ * the scope is left by an exception, the held notifications are dropped
+ */
+class CommandLine::ScopedBatch final {
+public:
+    explicit ScopedBatch(CommandLine* cmdline);
+
+    ScopedBatch(const ScopedBatch& batch)            = delete;
+    ScopedBatch& operator=(const ScopedBatch& batch) = delete;
+
+    ~ScopedBatch() noexcept(false);
+
+private:
+    /**
+     * The command line whose options are being assigned
+     */
+    CommandLine* cmdline_;
+
+    /**
+     * The number of exceptions in flight when the batch was opened
+     */
+    int exceptions_;
+};
+
+/**
+ * Constructor. Opens a batch
+ *
+ * @param[in] cmdline The command line whose options are being assigned
+ */
+CommandLine::ScopedBatch::ScopedBatch(CommandLine* cmdline)
+    : cmdline_(cmdline), exceptions_(std::uncaught_exceptions()) {
+    cmdline_->batch_(cmdline_->options_, BatchStep::kBegin);
+}
+
+/**
+ * Destructor. Closes the batch, delivering the held notifications if it
+ * is the outermost one and no exception is leaving its scope
+ */
+CommandLine::ScopedBatch::~ScopedBatch() noexcept(false) {
+    const BatchStep step = std::uncaught_exceptions() > exceptions_ ?
+        BatchStep::kAbort : BatchStep::kEnd;
+
+    cmdline_->batch_(cmdline_->options_, step);
+}
+
+/**
+ * Reports a parse to std::cerr if the command line asks for it, via a
+ * --cmdline_profile argument. The profile attached to the options is used
+ * if there is one; otherwise one is made and attached while this is in
+ * scope, so that an exception cannot leave it attached once it is freed
+ */
+class CommandLine::ProfileScope final {
+public:
+    explicit ProfileScope(CommandLine* cmdline) noexcept;
+
+    ProfileScope(const ProfileScope& scope)            = delete;
+    ProfileScope& operator=(const ProfileScope& scope) = delete;
+
+    ~ProfileScope();
+
+    bool Begin(const ParsedArgs& args);
+
+    void End() const;
+
+    std::pmr::memory_resource* Resource() const noexcept;
+
+private:
+    /**
+     * The command line being parsed
+     */
+    CommandLine* cmdline_;
+
+    /**
+     * The profile made for this parse, if any
+     */
+    std::unique_ptr<StartupProfile> owned_;
+
+    /**
+     * The profile to report, or null if no report was asked for
+     */
+    StartupProfile* report_;
+};
+
+/**
+ * Constructor. Nothing is profiled until \ref Begin()
+ *
+ * @param[in] cmdline The command line being parsed
+ */
+CommandLine::ProfileScope::ProfileScope(CommandLine* cmdline) noexcept
+    : cmdline_(cmdline), owned_(), report_(nullptr) {
+}
+
+/**
+ * Destructor. Detaches the profile made for this parse, if any
+ */
+CommandLine::ProfileScope::~ProfileScope() {
+    if (owned_) cmdline_->set_profile_(cmdline_->options_, nullptr);
+}
+
+/**
+ * Start profiling if the command line asks for a report. A request such
+ * as --cmdline_profile=0 is declined, and one whose value is not a bool is
+ * recorded as an error
+ *
+ * @param[in] args The tokenized command line
+ *
+ * @return True if a profile was made for this parse, in which case it was
+ *         not attached while \a args were tokenized
+ */
+bool CommandLine::ProfileScope::Begin(const ParsedArgs& args) {
+    const auto iter = args.Find(kProfileName);
+    if (iter == args.end()) return false;
+
+    bool requested = false;
+
+    const CmdLineError error = internal::FromString(iter->second,
+                                                    &requested);
+    if (error != CmdLineError::kSuccess) {
+        cmdline_->errors_.push_back({std::string(kProfileName), error});
+        return false;
+    }
+
+    if (!requested) return false;
+
+    report_ = cmdline_->profile_(cmdline_->options_);
+    if (report_ != nullptr) return false;
+
+    owned_ = std::make_unique<StartupProfile>(cmdline_->resource_);
+    cmdline_->set_profile_(cmdline_->options_, owned_.get());
+
+    report_ = owned_.get();
+    return true;
+}
+
+/**
+ * Write the report, if one was asked for, to std::cerr
+ */
+void CommandLine::ProfileScope::End() const {
+    if (report_ != nullptr) report_->Report(std::cerr);
+}
+
+/**
+ * Get the memory resource the rest of the parse should allocate from
+ *
+ * @return The profile made for this parse, which forwards to the options'
+ *         resource, or else the options' resource itself
+ */
+std::pmr::memory_resource*
+CommandLine::ProfileScope::Resource() const noexcept {
+    if (owned_) return owned_.get();
+
+    return cmdline_->resource_;
+}
+
+/**
+ * A static function that parses the command line into option, value pairs.
+ * Each argument is scanned exactly once and in place, so the cost is linear
+ * in the total length of the command line.
+ *
+ * Arguments are taken as the shell split them. An argument that does not
+ * begin with "--" continues the value of the option before it, so that
+ * --msg=hello world sets msg to "hello world", but an argument is never
+ * split: "--a=b --c=d" given as one argument sets a to "b --c=d". An
+ * option with '=' but no value in the same argument is ill-formed, e.g.
+ * --a= x, rather than taking its value from the next argument.
+ *
+ * An argument of the form \@file is replaced by the arguments in that file,
+ * one per line. Blank lines and lines starting with '#' are skipped, and a
+ * file may include other files the same way; relative paths are resolved
+ * against the directory of the including file. Only whole lines are
+ * comments: a '#' later in a line is part of the argument, as it would be
+ * on the command line. Files are memory-mapped and viewed in place
+ *
+ * @param[in] argc  Number of command line arguments
+ * @param[in] argv  The arguments themselves
+ * @param[out] args The option, value pairs, which view into \a argv
+ *
+ * @return True on success, or false if the command line is ill-formed, a
+ *         response file cannot be read, or response files include each
+ *         other in a cycle
+ */
+bool CommandLine::GetOptVal(int argc, char** argv, ParsedArgs& args) {
+    if (argc <= 0) return false;
+    args.clear();
+
+    args.pairs_.reserve(argc - 1);
+
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg(argv[i]);
+
+        if (!ParseArg(arg, arg.find('='), std::string(), &files, args))
+            return false;
+    }
+
+    args.Finalize();
+
+    return true;
+}
+
+/**
+ * A static function that parses a config file into option, value pairs. The
+ * file holds one "name = value" pair per line, in the style of INI or TOML:
+ *
+ * @verbatim
+   # comment
+   verbose = true
+
+   [storage.cache]
+   # the name of this option is storage.cache.size
+   size = 1024      # bytes
+   host = "local host"
+   @endverbatim
+ *
+ * Names under a [section] header are prefixed by the section and a '.'.
+ * Values may be enclosed in single or double quotes, which are removed.
+ * Lines starting with '#' or ';' are comments, and so is the rest of a
+ * line from a '#' or ';' that follows whitespace after a value, or that
+ * follows a quoted value. The file is memory-mapped and viewed in place,
+ * as with response files
+ *
+ * @param[in]  path The config file
+ * @param[out] args The option, value pairs
+ *
+ * @return True on success, or false if the file cannot be read or a line
+ *         is ill-formed
+ */
+bool CommandLine::GetConfigVal(const std::string& path, ParsedArgs& args) {
+    args.clear();
+
+    internal::MappedFile file;
+    if (!file.Open(path)) return false;
+
+    const std::string_view contents = file.Contents();
+    args.files_.push_back(std::move(file));
+
+    const internal::DelimiterIndex index(
+        contents, internal::DelimiterIndex::Mode::kSimd, args.Resource());
+
+    std::string_view section;
+
+    std::size_t start = 0;
+    while (start < contents.size()) {
+        const std::string_view line = NextLine(contents, index, &start);
+
+        if (line.empty() || line[0] == '#' || line[0] == ';') continue;
+
+        if (line.front() == '[') {
+            if (line.back() != ']') return false;
+
+            section = internal::Trim(line.substr(1, line.size() - 2));
+            continue;
+        }
+
+        const std::size_t equal = FindEqual(contents, index, line);
+        if (equal == std::string_view::npos) return false;
+
+        const std::string_view name  = internal::Trim(line.substr(0, equal));
+        const std::string_view value = ConfigValue(line.substr(equal + 1));
+
+        if (name.empty()) return false;
+
+        if (section.empty()) {
+            args.Append(name, value);
+        } else {
+            std::pmr::string qualified(args.Resource());
+            qualified.reserve(section.size() + 1 + name.size());
+            qualified.append(section).append(1, '.').append(name);
+
+            args.Append(std::move(qualified), value);
+        }
+    }
+
+    args.Finalize();
+
+    return true;
+}
 
 /**
- * A static function that parses the command line into option, value pairs
+ * A static function that parses the command line into option, value pairs.
+ * This is a compatibility wrapper which copies the result of the
+ * \ref ParsedArgs overload
  *
  * @param[in] argc     Number of command line arguments
  * @param[in] argv     The arguments themselves
@@ -36,57 +1699,139 @@ constexpr char TypeToName<std::string>::value[];
  */
 bool CommandLine::GetOptVal(int argc, char** argv,
                             std::map<std::string, std::string>& opt_val) {
-    if (argc <= 0) return false;
     opt_val.clear();
 
-    if (argc <= 1) return true;
+    ParsedArgs args;
+    if (!GetOptVal(argc, argv, args)) return false;
+
+    for (const auto& pair : args) {
+        opt_val.emplace_hint(opt_val.end(), pair.first, pair.second);
+    }
+
+    return true;
+}
+/**
+ * Add a single argument to the parsed command line
+ *
+ * @param[in]     arg   The argument
+ * @param[in]     equal The offset of the first '=' in \a arg, or npos
+ * @param[in]     dir   The directory against which to resolve a relative
+ *                      response file path. Empty for the working directory
+ * @param[in,out] files The response files currently being read
+ * @param[out]    args  The parsed command line
+ *
+ * @return True on success
+ */
+bool CommandLine::ParseArg(std::string_view arg,
+                           std::size_t equal,
+                           const std::string& dir,
+                           std::vector<std::string>* files,
+                           ParsedArgs& args) {
+    ArgToken token;
+    ScanArg(arg, equal, &token);
+
+    if (!token.is_option) {
+        if (token.value.size() > 1 && token.value[0] == '@')
+            return ParseFile(token.value.substr(1), dir, files, args);
 
-    std::vector<std::string> tokens;
+        /*
+         * Make sure the first entry starts with "--":
+         */
+        if (args.pairs_.empty()) return false;
 
-    for (int i = 1; i < argc; i++)
-        tokens.push_back(superstring(argv[i]).trim());
+        /*
+         * Otherwise this argument continues the value of the most
+         * recent option, e.g. --name=hello world
+         */
+        if (!token.value.empty()) args.Continue(token.value);
+        return true;
+    }
 
     /*
-     * Make sure the first entry starts with "--":
+     * Make sure neither the option name nor an explicitly given value
+     * is pure whitespace
      */
-    if (tokens[0].size() <= 2 || tokens[0][0] != '-' || tokens[0][1] != '-') {
+    if (internal::IsBlank(token.name)) return false;
+
+    if (token.has_equal && internal::IsBlank(token.value))
         return false;
-    }
 
-    const std::string cmdline =
-        superstring::build(" ", tokens.begin(), tokens.end());
+    args.Append(token.name, token.value);
+    return true;
+}
+
+/**
+ * Add each argument in a response file to the parsed command line
+ *
+ * @param[in]     name  The path to the response file
+ * @param[in]     dir   The directory against which to resolve a relative
+ *                      \a name. Empty for the working directory
+ * @param[in,out] files The response files currently being read, used to
+ *                      detect cycles
+ * @param[out]    args  The parsed command line
+ *
+ * @return True on success
+ */
+bool CommandLine::ParseFile(std::string_view name,
+                            const std::string& dir,
+                            std::vector<std::string>* files,
+                            ParsedArgs& args) {
+    std::filesystem::path path(name);
+    if (path.is_relative() && !dir.empty())
+        path = std::filesystem::path(dir) / path;
+
+    std::error_code error;
+    path = std::filesystem::canonical(path, error);
+    if (error) return false;
 
-    std::size_t start = 0, equal;
-    std::string subline = cmdline.substr(start, std::string::npos);
-    while (NextPair(subline, &start, &equal)) {
-        start += 2;
-        const std::string name =
-            subline.substr(start, equal-start);
+    const std::string canonical = path.string();
 
-        /*
-         * Make sure the option name is not pure whitespace
-         */
-        if (superstring(name).trim().size() == 0)
-            return false;
+    if (std::find(files->begin(), files->end(), canonical) != files->end())
+        return false;
 
-        subline = subline.substr(equal + 1, std::string::npos);
+    internal::MappedFile file;
+    if (!file.Open(canonical)) return false;
 
-        const std::string value =
-            NextPair(subline, &start, &equal) ? subline.substr(0, start) :
-                                                subline;
+    const std::string_view contents = file.Contents();
+    args.files_.push_back(std::move(file));
 
-        /*
-         * Make sure the option value is not pure whitespace
-         */
-        if (superstring(value).trim().size() == 0)
-            return false;
+    files->push_back(canonical);
+    const std::string parent = path.parent_path().string();
+
+    const internal::DelimiterIndex index(
+        contents, internal::DelimiterIndex::Mode::kSimd, args.Resource());
+
+    std::size_t start = 0;
+    while (start < contents.size()) {
+        const std::string_view line = NextLine(contents, index, &start);
 
-        opt_val[name] = value;
+        if (line.empty() || line[0] == '#') continue;
+
+        const std::size_t equal = FindEqual(contents, index, line);
+
+        if (!ParseArg(line, equal, parent, files, args)) return false;
     }
 
+    files->pop_back();
     return true;
 }
-#if 0
+
+/**
+ * Destructor
+ */
+CommandLine::~CommandLine() {
+}
+
+/**
+ * Get the options rejected by the most recent call to \ref parse()
+ *
+ * @return One entry per rejected option
+ */
+auto CommandLine::Errors() const noexcept
+    -> const std::vector<OptionError>& {
+    return errors_;
+}
+
 /**
  *  Parse the command line, assigning a value to each command
  *  line option. The command line should have the form:
@@ -100,173 +1845,293 @@ bool CommandLine::GetOptVal(int argc, char** argv,
  * without a value. It is understood that value equals true
  * in this case
  *
+ * Every option is attempted, even after an error; see \ref Errors() for
+ * the options that were rejected and why
+ *
+ * If the arguments include --cmdline_profile, or --cmdline_profile=1, the
+ * time spent in each phase of the parse is written to std::cerr when it is
+ * done; see \ref StartupProfile. If the options have a profile, that
+ * profile is reported, including the options' registration
+ *
  * @param[in] argc The total number of command line arguments
  * @param[in] argv The arguments themselves
  *
  * @return True on success
  */
-bool CommandLine::parse(int argc, char** argv)
-{
-    std::map<std::string,std::string>
-        cmdline;
-    AbortIfNot(get_opt_val( argc, argv, cmdline ), false);
+bool CommandLine::parse(int argc, char** argv) {
+    errors_.clear();
 
-    for (auto iter = cmdline.begin(), end = cmdline.end();
-         iter != end; ++iter)
-    {
-        auto opt_iter =
-            _options._options.find(iter->first);
+    ProfileScope profiling(this);
+    std::optional<ParsedArgs> args;
 
-        AbortIf(opt_iter== _options._options.end(), false,
-            "unknown option '%s'", iter->first.c_str());
+    if (Tokenize(argc, argv, &profiling, &args)) {
+        Apply(*args, true);
+    } else {
+        errors_.push_back({std::string(), CmdLineError::kInvalidCmdLine});
+    }
 
-        const std::string& type =
-            opt_iter->second->get_type();
-        const std::string& val  =
-            Util::to_lower(iter->second);
+    profiling.End();
 
-        if (type == "bool")
-        {
-            bool value;
+    return errors_.empty();
+}
 
-            /*
-             * Note: If val == "", that means that --option was
-             *       provided without a value. For the case
-             *       of a boolean option, this is understood as
-             *       setting its flag
-             */
-            if (val == "" || val == "true"  || val == "1")
-                value = true;
-            else if (val == "false" || val == "0")
-                value = false;
-            else
-            {
-                Abort(false);
-            }
-
-            AbortIfNot(_options.set(iter->first, value),
-                false);
-        }
-        else if (type == "char")
-        {
-            char value;
-            if (val.size() == 1)
-            {
-                value = iter->second[0];
-                AbortIfNot(_options.set(iter->first,
-                    value), false);
-            }
-            else
-            {
-                Abort(false);
-            }
-        }
-        else if (type == "int16")
-        {
-            std::int16_t value;
-            AbortIfNot(Util::from_string(val, value), false);
+/**
+ * Assign options from a config file and then from the command line. An
+ * option therefore takes its default value, unless set by the config file,
+ * unless set on the command line. See \ref GetConfigVal() for the file
+ * format
+ *
+ * Every option is attempted, even after an error; see \ref Errors() for
+ * the options that were rejected and why. As with \ref parse(int, char**),
+ * a --cmdline_profile argument reports the time spent in each phase
+ *
+ * @param[in] argc   The total number of command line arguments
+ * @param[in] argv   The arguments themselves
+ * @param[in] config The path to the config file
+ *
+ * @return True on success
+ */
+bool CommandLine::parse(int argc, char** argv, const std::string& config) {
+    errors_.clear();
 
-            AbortIfNot(_options.set(iter->first, value),
-                false);
-        }
-        else if (type == "int32")
-        {
-            std::int32_t value;
-            AbortIfNot(Util::from_string(val, value), false);
+    // The command line is tokenized first to learn if it asks for a profile
 
-            AbortIfNot(_options.set(iter->first, value),
-                false);
-        }
-        else if (type == "uchar")
-        {
-            unsigned char value;
-
-            if (val.size() == 1)
-            {
-                value = iter->second[ 0 ];
-                AbortIfNot(_options.set(iter->first,value),
-                    false);
-            }
-            else
-            {
-                Abort(false);
-            }
-        }
-        else if (type == "uint16")
-        {
-            std::uint16_t value;
-            AbortIfNot(Util::from_string(val, value), false);
+    ProfileScope profiling(this);
+    std::optional<ParsedArgs> args;
 
-            AbortIfNot(_options.set(iter->first, value),
-                false);
-        }
-        else if (type == "uint32")
-        {
-            std::uint32_t value;
-            AbortIfNot(Util::from_string(val, value), false);
+    const bool tokenized = Tokenize(argc, argv, &profiling, &args);
 
-            AbortIfNot(_options.set(iter->first, value),
-                false);
-        }
-        else if (type == "float")
-        {
-            float value;
-            AbortIfNot(Util::from_string(val, value), false);
+    // Notify listeners once for both sources
 
-            AbortIfNot(_options.set(iter->first, value),
-                false);
-        }
-        else if (type == "double")
-        {
-            double value;
-            AbortIfNot(Util::from_string(val, value), false);
+    {
+        ScopedBatch batch(this);
 
-            AbortIfNot(_options.set(iter->first, value),
-                false);
-        }
-        else if (type == "string")
-        {
-            AbortIfNot(_options.set(iter->first,
-                iter->second), false);
+        ParsedArgs config_args(profiling.Resource());
+
+        StartupProfile::Timer tokenizing(profile_(options_),
+                                         StartupProfile::Phase::kTokenize);
+        const bool read = GetConfigVal(config, config_args);
+        tokenizing.Stop();
+
+        if (read) {
+            Apply(config_args, false);
+        } else {
+            errors_.push_back({config, CmdLineError::kInvalidConfig});
         }
-        else
-        {
-            Abort(false, "unsupported type '%s'",
-                type.c_str());
+
+        if (tokenized) {
+            Apply(*args, true);
+        } else {
+            errors_.push_back({std::string(),
+                               CmdLineError::kInvalidCmdLine});
         }
     }
 
+    profiling.End();
+
+    return errors_.empty();
+}
+
+/**
+ * Re-read a config file and apply its values as a whole: readers of
+ * BasicUserOptions::Current() see either every value from the file or
+ * none of them. Options absent from the file keep their current values,
+ * and if any value is rejected, nothing is applied. See \ref Errors() for
+ * the options that were rejected and why
+ *
+ * @param[in] config The path to the config file
+ *
+ * @return True on success
+ */
+bool CommandLine::reload(const std::string& config) {
+    errors_.clear();
+
+    ParsedArgs args(resource_);
+    if (!GetConfigVal(config, args)) {
+        errors_.push_back({config, CmdLineError::kInvalidConfig});
+        return false;
+    }
+
+    reload_(options_, args, &errors_);
+
+    return errors_.empty();
+}
+
+/**
+ * Answer a shell completion query, if that is what the command line is. A
+ * completion script (see \ref completion_script()) runs the program as
+ *
+ * @verbatim
+   <program_name> --__complete=<word>
+   @endverbatim
+ *
+ * to get the completions of the argument being typed, which are written to
+ * \a os one per line. The options need to have been added, but nothing is
+ * parsed. A program should check for a query before doing anything else,
+ * and exit if this returns true:
+ *
+ * @verbatim
+   if (cmd.complete(argc, argv, std::cout)) return 0;
+   @endverbatim
+ *
+ * @param[in] argc The total number of command line arguments
+ * @param[in] argv The arguments themselves
+ * @param[in] os   The stream to write completions to
+ *
+ * @return True if the command line was a completion query
+ */
+bool CommandLine::complete(int argc, char** argv, std::ostream& os) const {
+    constexpr std::string_view kQuery("--__complete=");
+
+    if (argc != 2) return false;
+
+    const std::string_view arg(argv[1]);
+    if (arg.compare(0, kQuery.size(), kQuery) != 0) return false;
+
+    std::vector<std::string> candidates;
+    complete_(options_, arg.substr(kQuery.size()), &candidates);
+
+    std::string output;
+    for (const std::string& candidate : candidates)
+        output.append(candidate).push_back('\n');
+
+    os.write(output.data(), static_cast<std::streamsize>(output.size()));
+
     return true;
 }
-#endif
 
 /**
- * Helper method that searches for the next pair of "--" and "=" substrings
- * 
- * @param[in]  str     The search string
- * @param[out] p_start Index of the next "--"
- * @param[out] p_equal Index of the next "="
- * 
- * @return True if a pair was found, false otherwise
+ * Write a script which enables tab completion of a program's options. The
+ * script runs the program with a completion query for each completion;
+ * see \ref complete(). For example, in bash:
+ *
+ * @verbatim
+   source <(program_name --completion=bash)
+   @endverbatim
+ *
+ * where --completion is a flag of the program's choosing that calls this.
+ * The zsh script may instead be saved as _program_name on the $fpath
+ *
+ * @param[in] shell     The shell which will run the script
+ * @param[in] prog_name The name of the program, as typed at the prompt
+ * @param[in] os        The stream to write the script to
  */
-bool CommandLine::NextPair(const std::string& str,
-                           std::size_t* p_start,
-                           std::size_t* p_equal) {
-    std::size_t start = str.find("--");
-    if (start == std::string::npos) return false;
+void CommandLine::completion_script(Shell shell,
+                                    const std::string& prog_name,
+                                    std::ostream& os) {
+    const std::string name =
+        std::filesystem::path(prog_name).filename().string();
 
-    std::size_t equal = str.find("=", start);
-    if (equal == std::string::npos) return false;
+    std::string function("_");
+    for (char c : name)
+        function.push_back(std::isalnum(static_cast<unsigned char>(c)) ?
+                           c : '_');
+    function.append("_complete");
 
-    std::size_t next = start;
-    while (next < equal && next != std::string::npos) {
-        start = next;
-        next = str.find("--", start + 2);
+    std::string script;
+
+    if (shell == Shell::kBash) {
+        /*
+         * bash splits "--name=value" at the '=', so the query is made with
+         * the whole argument and the name is stripped from the answers.
+         * The answers are read one per line rather than word-split, so
+         * that values such as '*' are not expanded as globs
+         */
+        script.append(function).append("() {\n")
+              .append("    local line=\"${COMP_LINE:0:COMP_POINT}\"\n")
+              .append("    local word=\"${line##* }\"\n")
+              .append("    mapfile -t COMPREPLY < <(\"${COMP_WORDS[0]}\" ")
+              .append("--__complete=\"$word\" 2>/dev/null)\n")
+              .append("    if [[ \"$word\" == *=* ]]; then\n")
+              .append("        COMPREPLY=(\"${COMPREPLY[@]#*=}\")\n")
+              .append("    elif [[ ${#COMPREPLY[@]} -eq 1 && ")
+              .append("\"${COMPREPLY[0]}\" == *= ]]; then\n")
+              .append("        compopt -o nospace\n")
+              .append("    fi\n")
+              .append("}\n")
+              .append("complete -F ").append(function).append(" ")
+              .append(name).append("\n");
+    } else {
+        script.append("#compdef ").append(name).append("\n")
+              .append(function).append("() {\n")
+              .append("    local -a found options values\n")
+              .append("    local candidate\n")
+              .append("    found=(\"${(@f)$(\"${words[1]}\" ")
+              .append("--__complete=\"${words[CURRENT]}\" ")
+              .append("2>/dev/null)}\")\n")
+              .append("    for candidate in \"${found[@]}\"; do\n")
+              .append("        if [[ $candidate == *= ]]; then\n")
+              .append("            options+=(\"$candidate\")\n")
+              .append("        elif [[ -n $candidate ]]; then\n")
+              .append("            values+=(\"$candidate\")\n")
+              .append("        fi\n")
+              .append("    done\n")
+              .append("    compadd -Q -S '' -- \"${options[@]}\"\n")
+              .append("    compadd -Q -- \"${values[@]}\"\n")
+              .append("}\n")
+              .append("compdef ").append(function).append(" ")
+              .append(name).append("\n");
     }
 
-    *p_start = start;
-    *p_equal = equal;
+    os.write(script.data(), static_cast<std::streamsize>(script.size()));
+}
 
-    return true;
+/**
+ * Assign each parsed option its value, recording any errors. Listeners
+ * are notified once for the whole set
+ *
+ * @param[in] args         The option, value pairs
+ * @param[in] command_line True if \a args are from the command line, in
+ *                         which case a request for a profile is not an
+ *                         option to assign
+ */
+void CommandLine::Apply(const ParsedArgs& args, bool command_line) {
+    ScopedBatch batch(this);
+
+    for (const auto& pair : args) {
+        if (command_line && pair.first == kProfileName) continue;
+
+        const CmdLineError error =
+            set_from_string_(options_, pair.first, pair.second);
+
+        if (error != CmdLineError::kSuccess)
+            errors_.push_back({std::string(pair.first), error});
+    }
+}
+
+/**
+ * Tokenize the command line, starting a profile if it asks for one. A
+ * profile made for this parse did not exist while the command line was
+ * first tokenized, so that is done again under it; only a parse that asks
+ * for a report pays for this
+ *
+ * @param[in]     argc      The total number of command line arguments
+ * @param[in]     argv      The arguments themselves
+ * @param[in,out] profiling Starts the profile, if asked for
+ * @param[out]    args      The option, value pairs
+ *
+ * @return True if the command line is well-formed
+ */
+bool CommandLine::Tokenize(int argc, char** argv,
+                           ProfileScope* profiling,
+                           std::optional<ParsedArgs>* args) {
+    args->emplace(resource_);
+
+    StartupProfile::Timer tokenizing(profile_(options_),
+                                     StartupProfile::Phase::kTokenize);
+    const bool tokenized = GetOptVal(argc, argv, **args);
+    tokenizing.Stop();
+
+    if (!tokenized || !profiling->Begin(**args))
+        return tokenized;
+
+    // A profile made for this parse counts, then forwards to resource_
+
+    args->emplace(profiling->Resource());
+
+    StartupProfile::Timer retokenizing(profile_(options_),
+                                       StartupProfile::Phase::kTokenize);
+    return GetOptVal(argc, argv, **args);
 }
+
 }  // namespace jfern
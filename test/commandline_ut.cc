@@ -4,9 +4,23 @@
  *  \date   07/04/2021
  */
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory_resource>
+#include <set>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -57,6 +71,35 @@ protected:
     char* m_args[64];
 };
 
+/*
+ * Counts what is outstanding so we can check that everything went through
+ * this resource and that all of it was given back. Allocating fails once
+ * the budget runs out
+ */
+class CountingResource : public std::pmr::memory_resource {
+public:
+    std::size_t allocations = 0;
+    std::size_t outstanding = 0;
+    std::size_t budget      = SIZE_MAX;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t align) override {
+        if (budget == 0) throw std::bad_alloc();
+        budget--; allocations++; outstanding += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, align);
+    }
+
+    void do_deallocate(void* ptr, std::size_t bytes,
+                       std::size_t align) override {
+        outstanding -= bytes;
+        std::pmr::new_delete_resource()->deallocate(ptr, bytes, align);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
 template <typename T>
 class UserOptionsTest : public ::testing::Test {
  public:
@@ -385,6 +428,57 @@ TYPED_TEST(UserOptionsTest, Default) {
     }
 }
 
+TYPED_TEST(UserOptionsTest, Bind) {
+    const std::string option_name = "hello";
+    jfern::CommandLineOptions options;
+    ASSERT_EQ(jfern::CmdLineError::kSuccess,
+              options.Add<TypeParam>(option_name,
+                                     DefaultValue<TypeParam>(),
+                                     "some option"));
+
+    jfern::CommandLineOptions::OptionHandle<TypeParam> handle;
+    EXPECT_FALSE(handle.Valid());
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              options.Bind(option_name, &handle));
+
+    ASSERT_TRUE(handle.Valid());
+    EXPECT_EQ(handle.Default(), DefaultValue<TypeParam>());
+    EXPECT_EQ(handle.Value(), DefaultValue<TypeParam>());
+
+    // The handle sees updates and survives reallocation of the storage
+
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(jfern::CmdLineError::kSuccess,
+                  options.Add<TypeParam>("opt" + std::to_string(i),
+                                         AssignedValue<TypeParam>()));
+    }
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              options.Set<TypeParam>(option_name, AssignedValue<TypeParam>()));
+
+    EXPECT_EQ(handle.Default(), DefaultValue<TypeParam>());
+    EXPECT_EQ(handle.Value(), AssignedValue<TypeParam>());
+
+    // Error cases
+
+    EXPECT_EQ(jfern::CmdLineError::kDoesNotExist,
+              options.Bind("howdy", &handle));
+
+    EXPECT_EQ(jfern::CmdLineError::kEmptyName,
+              options.Bind(" ", &handle));
+
+    if (std::is_same<std::uint32_t, TypeParam>::value) {
+        jfern::CommandLineOptions::OptionHandle<std::uint64_t> other;
+        EXPECT_EQ(jfern::CmdLineError::kWrongType,
+                  options.Bind(option_name, &other));
+    } else {
+        jfern::CommandLineOptions::OptionHandle<std::uint32_t> other;
+        EXPECT_EQ(jfern::CmdLineError::kWrongType,
+                  options.Bind(option_name, &other));
+    }
+}
+
 TYPED_TEST(UserOptionsTest, Delete) {
     const std::string option_name = "hello";
     jfern::CommandLineOptions options;
@@ -405,40 +499,2134 @@ TYPED_TEST(UserOptionsTest, Delete) {
     EXPECT_EQ(jfern::CmdLineError::kDoesNotExist, options.Delete(" "));
 }
 
-TEST_F(CommandLineTest, GetOptVal) {
-    std::string cmdline = "program_name"
-                          " --bool_opt=true"
-                          " --i8_opt=i8_value"
-                          " --i16_opt=i16_value"
-                          " --i32_opt=i32_value"
-                          " --i64_opt=i64_value"
-                          " --u8_opt=u8_value"
-                          " --u16_opt=u16_value"
-                          " --u32_opt=u32_value"
-                          " --u64_opt=u64_value"
-                          " --float_opt=float_value"
-                          " --double_opt=double_value"
-                          " --string_opt=string_value";
+TYPED_TEST(UserOptionsTest, DeleteMany) {
+    jfern::CommandLineOptions options;
 
-    int argc;
-    char** argv = CmdlineToArgv(cmdline, &argc);
+    for (int i = 0; i < 10; i++) {
+        ASSERT_EQ(jfern::CmdLineError::kSuccess,
+                  options.Add<TypeParam>("opt" + std::to_string(i),
+                                         DefaultValue<TypeParam>()));
+        ASSERT_EQ(jfern::CmdLineError::kSuccess,
+                  options.Add<std::int32_t>("other" + std::to_string(i), i));
+    }
 
-    std::map<std::string, std::string> opt2val;
-    ASSERT_TRUE(jfern::CommandLine::GetOptVal(argc, argv, opt2val));
+    // Delete from the front, middle and back
 
-    EXPECT_EQ(opt2val.size(), 12u);
-    EXPECT_EQ(jfern::superstring(opt2val["bool_opt"]).trim(), "true");
-    EXPECT_EQ(jfern::superstring(opt2val["i8_opt"]).trim(), "i8_value");
-    EXPECT_EQ(jfern::superstring(opt2val["i16_opt"]).trim(), "i16_value");
-    EXPECT_EQ(jfern::superstring(opt2val["i32_opt"]).trim(), "i32_value");
-    EXPECT_EQ(jfern::superstring(opt2val["i64_opt"]).trim(), "i64_value");
-    EXPECT_EQ(jfern::superstring(opt2val["u8_opt"]).trim(), "u8_value");
-    EXPECT_EQ(jfern::superstring(opt2val["u16_opt"]).trim(), "u16_value");
-    EXPECT_EQ(jfern::superstring(opt2val["u32_opt"]).trim(), "u32_value");
-    EXPECT_EQ(jfern::superstring(opt2val["u64_opt"]).trim(), "u64_value");
-    EXPECT_EQ(jfern::superstring(opt2val["float_opt"]).trim(), "float_value");
-    EXPECT_EQ(jfern::superstring(opt2val["double_opt"]).trim(), "double_value");
-    EXPECT_EQ(jfern::superstring(opt2val["string_opt"]).trim(), "string_value");
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Delete("opt0"));
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Delete("opt5"));
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Delete("opt9"));
+
+    for (int i = 0; i < 10; i++) {
+        const std::string name = "opt" + std::to_string(i);
+
+        if (i == 0 || i == 5 || i == 9) {
+            EXPECT_FALSE(options.Exists(name));
+            continue;
+        }
+
+        EXPECT_EQ(jfern::CmdLineError::kSuccess,
+                  options.Set<TypeParam>(name, AssignedValue<TypeParam>()));
+
+        TypeParam value;
+        EXPECT_EQ(jfern::CmdLineError::kSuccess,
+                  options.Get<TypeParam>(name, &value));
+        EXPECT_EQ(value, AssignedValue<TypeParam>());
+    }
+
+    if (!std::is_same<std::int32_t, TypeParam>::value) {
+        for (int i = 0; i < 10; i++) {
+            std::int32_t value = -1;
+            EXPECT_EQ(jfern::CmdLineError::kSuccess,
+                      options.Get("other" + std::to_string(i), &value));
+            EXPECT_EQ(value, i);
+        }
+    }
+
+    // A deleted name may be reused with a different type
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              options.Add<std::string>("opt5", "reused"));
+
+    std::string value;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Get("opt5", &value));
+    EXPECT_EQ(value, "reused");
+}
+
+TEST(UserOptionsPrintTest, Print) {
+    jfern::CommandLineOptions options;
+    options.Add<std::int32_t>("zeta", 5, "the last option");
+    options.Add<bool>("alpha", true, "the first option");
+
+    std::ostringstream os;
+    options.Print("program", os);
+
+    const std::string output = os.str();
+
+    EXPECT_EQ(output.find("usage: program [options]"), 0u);
+
+    const std::size_t alpha = output.find("--alpha=<bool> [true]");
+    const std::size_t zeta  = output.find("--zeta=<int32> [5]");
+
+    ASSERT_NE(alpha, std::string::npos);
+    ASSERT_NE(zeta,  std::string::npos);
+    EXPECT_LT(alpha, zeta);
+
+    EXPECT_NE(output.find("the first option"), std::string::npos);
+}
+
+TEST(UserOptionsPrintTest, PrefixAndAlignment) {
+    jfern::CommandLineOptions options;
+    options.Add<std::int32_t>("net.port", 80, "The port");
+    options.Add<std::string>("net.host", "localhost", "The host");
+    options.Add<std::int32_t>("network", 1, "Not in the net group");
+
+    std::ostringstream os;
+    options.Print("program", os, "net.");
+
+    EXPECT_EQ(os.str(),
+              "usage: program [options]\n"
+              "options:\n"
+              "\n"
+              "  --net.host=<string> [localhost]  The host\n"
+              "  --net.port=<int32> [80]          The port\n");
+
+    // The cached list is rebuilt after the options change
+
+    options.Add<bool>("net.ipv6", false);
+    options.Delete("net.host");
+
+    os.str("");
+    options.Print("program", os, "net.");
+
+    const std::string output = os.str();
+    EXPECT_NE(output.find("--net.ipv6=<bool> [false]\n"), std::string::npos);
+    EXPECT_EQ(output.find("net.host"), std::string::npos);
+    EXPECT_EQ(output.find("network"), std::string::npos);
+}
+
+TEST(UserOptionsGroupTest, GetAndReset) {
+    jfern::CommandLineOptions options;
+    options.Add<std::int32_t>("storage.cache.size", 64);
+    options.Add<std::int32_t>("storage.cache.ttl", 30);
+    options.Add<bool>("storage.verbose", false);
+    options.Add<std::string>("storage2.path", "/tmp");
+
+    EXPECT_EQ(options.Names("storage.c"),
+              std::vector<std::string>({"storage.cache.size",
+                                        "storage.cache.ttl"}));
+
+    options.Set<std::int32_t>("storage.cache.ttl", 60);
+    options.Set<std::string>("storage2.path", "/var");
+
+    std::vector<std::pair<std::string, std::string>> values;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              options.GetGroup("storage.cache", &values));
+
+    using Values = std::vector<std::pair<std::string, std::string>>;
+    EXPECT_EQ(values, Values({{"storage.cache.size", "64"},
+                              {"storage.cache.ttl", "60"}}));
+
+    std::vector<std::vector<std::string>> calls;
+    options.SubscribeGroup("", [&](const std::vector<std::string>& names) {
+        calls.push_back(names);
+    });
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.ResetGroup("storage"));
+
+    ASSERT_EQ(calls.size(), 1u);
+    EXPECT_EQ(calls[0], std::vector<std::string>({"storage.cache.ttl"}));
+
+    std::int32_t ttl = 0;
+    std::string path;
+    options.Get("storage.cache.ttl", &ttl);
+    options.Get("storage2.path", &path);
+    EXPECT_EQ(ttl, 30);
+    EXPECT_EQ(path, "/var");
+
+    EXPECT_EQ(jfern::CmdLineError::kDoesNotExist,
+              options.ResetGroup("storage.cach"));
+
+    options.Delete("storage.cache.size");
+    EXPECT_EQ(options.Names("storage.cache"),
+              std::vector<std::string>({"storage.cache.ttl"}));
+}
+
+TEST(UserOptionsBulkTest, AddAllAndSetAll) {
+    using Options = jfern::CommandLineOptions;
+
+    Options options;
+    options.Reserve(8);
+    options.Add<std::int32_t>("existing", 0);
+
+    const std::vector<Options::Definition<std::int32_t>> sizes = {
+        { "cache.size", 64, "Entries held" },
+        { "cache.ttl",  30 }
+    };
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              options.AddAll<std::int32_t>(sizes.begin(), sizes.end()));
+
+    // A duplicate, within the batch or not, means nothing is added
+
+    const Options::Definition<bool> flags[] = {
+        { "cache.enabled", true },
+        { "cache.enabled", false }
+    };
+
+    EXPECT_EQ(jfern::CmdLineError::kDuplicate,
+              options.AddAll<bool>(std::begin(flags), std::end(flags)));
+    EXPECT_FALSE(options.Exists("cache.enabled"));
+
+    const Options::Definition<std::int32_t> clash[] = {
+        { "cache.max", 1 }, { "existing", 2 }
+    };
+
+    EXPECT_EQ(jfern::CmdLineError::kDuplicate,
+              options.AddAll<std::int32_t>(std::begin(clash),
+                                           std::end(clash)));
+    EXPECT_FALSE(options.Exists("cache.max"));
+
+    EXPECT_EQ(options.Names("cache."),
+              std::vector<std::string>({"cache.size", "cache.ttl"}));
+
+    std::vector<std::vector<std::string>> calls;
+    options.SubscribeGroup("", [&](const std::vector<std::string>& names) {
+        calls.push_back(names);
+    });
+
+    const std::vector<std::pair<std::string, std::int32_t>> values = {
+        { "cache.size", 128 }, { "cache.ttl", 60 }
+    };
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              options.SetAll<std::int32_t>(values.begin(), values.end()));
+
+    ASSERT_EQ(calls.size(), 1u);
+    EXPECT_EQ(calls[0],
+              std::vector<std::string>({"cache.size", "cache.ttl"}));
+
+    // One bad name means nothing is set
+
+    const std::vector<std::pair<std::string, std::int32_t>> bad = {
+        { "cache.size", 1 }, { "cache.missing", 2 }
+    };
+
+    EXPECT_EQ(jfern::CmdLineError::kDoesNotExist,
+              options.SetAll<std::int32_t>(bad.begin(), bad.end()));
+
+    std::int32_t size = 0;
+    options.Get("cache.size", &size);
+    EXPECT_EQ(size, 128);
+
+    std::ostringstream os;
+    options.Print("program", os, "cache.size");
+    EXPECT_NE(os.str().find("Entries held"), std::string::npos);
+}
+
+TEST(UserOptionsBulkTest, AddFailsCleanly) {
+    using Options = jfern::CommandLineOptions;
+
+    const Options::Definition<std::int32_t> sizes[] = {
+        { "cache.size", 64, "Entries held" },
+        { "cache.ttl",  30 },
+        { "cache.max",  1024 }
+    };
+
+    // Fail each allocation in turn, until adding gets through
+
+    for (std::size_t budget = 0;; budget++) {
+        CountingResource resource;
+        Options options(&resource);
+        options.Add<std::int32_t>("existing", 0);
+
+        resource.budget = budget;
+
+        try {
+            options.Add<std::int32_t>("count", 1, "How many");
+            options.AddAll<std::int32_t>(std::begin(sizes), std::end(sizes));
+            break;
+        } catch (const std::bad_alloc&) {
+        }
+
+        resource.budget = SIZE_MAX;
+
+        // Whatever was not added can be added now, and nothing is left
+        // half-added
+
+        if (!options.Exists("count")) {
+            EXPECT_EQ(jfern::CmdLineError::kSuccess,
+                      options.Add<std::int32_t>("count", 1));
+        }
+
+        for (const auto& definition : sizes) {
+            const std::string name(definition.name);
+
+            if (!options.Exists(name)) {
+                EXPECT_EQ(jfern::CmdLineError::kSuccess,
+                          options.Add<std::int32_t>(name, 0));
+            }
+        }
+
+        EXPECT_EQ(options.Names("cache."),
+                  std::vector<std::string>(
+                      {"cache.max", "cache.size", "cache.ttl"}));
+
+        std::int32_t count = 0;
+        EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Get("count", &count));
+        EXPECT_EQ(count, 1);
+    }
+}
+
+TEST(UserOptionsCompleteTest, Complete) {
+    jfern::CommandLineOptions options;
+    options.Add<std::int32_t>("net.port", 80);
+    options.Add<std::string>("net.host", "localhost");
+    options.Add<bool>("verbose", false);
+
+    std::vector<std::string> candidates;
+
+    options.Complete("--ne", &candidates);
+    EXPECT_EQ(candidates,
+              std::vector<std::string>({"--net.host=", "--net.port="}));
+
+    options.Complete("-", &candidates);
+    EXPECT_EQ(candidates,
+              std::vector<std::string>({"--net.host=", "--net.port=",
+                                        "--verbose"}));
+
+    options.Complete("--verbose=", &candidates);
+    EXPECT_EQ(candidates,
+              std::vector<std::string>({"--verbose=false",
+                                        "--verbose=true"}));
+
+    options.Complete("--verbose=t", &candidates);
+    EXPECT_EQ(candidates, std::vector<std::string>({"--verbose=true"}));
+
+    options.Complete("--net.host=", &candidates);
+    EXPECT_EQ(candidates, std::vector<std::string>({"--net.host=localhost"}));
+
+    options.Complete("--net.port=9", &candidates);
+    EXPECT_TRUE(candidates.empty());
+
+    options.Complete("--nothing=", &candidates);
+    EXPECT_TRUE(candidates.empty());
+
+    options.Complete("net", &candidates);
+    EXPECT_TRUE(candidates.empty());
+}
+
+TEST(ConcurrentUserOptionsTest, ReadWhileWriting) {
+    jfern::ConcurrentCommandLineOptions options;
+    ASSERT_EQ(jfern::CmdLineError::kSuccess,
+              options.Add<double>("ratio", 0.0));
+    ASSERT_EQ(jfern::CmdLineError::kSuccess,
+              options.Add<std::string>("name", std::string(64, 'a')));
+
+    jfern::ConcurrentCommandLineOptions::OptionHandle<double> ratio;
+    jfern::ConcurrentCommandLineOptions::OptionHandle<std::string> name;
+    ASSERT_EQ(jfern::CmdLineError::kSuccess, options.Bind("ratio", &ratio));
+    ASSERT_EQ(jfern::CmdLineError::kSuccess, options.Bind("name", &name));
+
+    constexpr int kWrites = 2000;
+
+    std::atomic<bool> done(false);
+    std::atomic<int>  torn(0);
+
+    // Every string written consists of one repeated character, so a reader
+    // that ever sees a mix has observed a torn write
+
+    auto uniform = [](const std::string& value) {
+        return value.size() == 64 &&
+            value.find_first_not_of(value[0]) == std::string::npos;
+    };
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&]() {
+            double last = 0.0;
+            while (!done.load()) {
+                const double value = ratio.Value();
+                if (value < last) torn++;
+                last = value;
+
+                if (!uniform(name.Value())) torn++;
+
+                name.Read([&](const std::string& value) {
+                    if (!uniform(value)) torn++;
+                });
+            }
+        });
+    }
+
+    for (int i = 1; i <= kWrites; i++) {
+        ASSERT_EQ(jfern::CmdLineError::kSuccess,
+                  options.Set<double>("ratio", i));
+        ASSERT_EQ(jfern::CmdLineError::kSuccess,
+                  options.Set("name", std::string(64, 'a' + i % 26)));
+    }
+
+    done = true;
+    for (auto& reader : readers)
+        reader.join();
+
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(ratio.Value(), kWrites);
+    EXPECT_EQ(name.Value(), std::string(64, 'a' + kWrites % 26));
+}
+
+TEST(UserOptionsSnapshotTest, StageAndPublish) {
+    jfern::CommandLineOptions options;
+    options.Add<std::int32_t>("count", 1);
+    options.Add<std::string>("name", "none");
+    options.Add<bool>("verbose", false);
+
+    EXPECT_EQ(options.Current(), nullptr);
+
+    // Changes to a staged snapshot are invisible until published
+
+    auto staged = options.Stage();
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, staged.Set("count", 2));
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              staged.SetFromString("name", "kirby"));
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              staged.SetFromString("verbose", "true"));
+
+    EXPECT_EQ(jfern::CmdLineError::kWrongType, staged.Set("count", 2.0));
+    EXPECT_EQ(jfern::CmdLineError::kDoesNotExist,
+              staged.SetFromString("missing", "1"));
+    EXPECT_EQ(jfern::CmdLineError::kInvalidValue,
+              staged.SetFromString("count", "two"));
+
+    std::int32_t count = 0;
+    options.Get("count", &count);
+    EXPECT_EQ(count, 1);
+    EXPECT_EQ(options.Current(), nullptr);
+
+    options.Publish(std::move(staged));
+
+    auto first = options.Current();
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first->Generation(), 1u);
+
+    options.Get("count", &count);
+    EXPECT_EQ(count, 2);
+
+    std::string name;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, first->Get("name", &name));
+    EXPECT_EQ(name, "kirby");
+
+    bool verbose = false;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, first->Get("verbose", &verbose));
+    EXPECT_TRUE(verbose);
+
+    // A snapshot held by a reader is unaffected by later publications
+
+    options.Set("count", 3);
+    options.Publish();
+
+    auto second = options.Current();
+    EXPECT_EQ(second->Generation(), 2u);
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, first->Get("count", &count));
+    EXPECT_EQ(count, 2);
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, second->Get("count", &count));
+    EXPECT_EQ(count, 3);
+
+    jfern::CommandLineOptions::OptionHandle<std::int32_t> handle;
+    ASSERT_EQ(jfern::CmdLineError::kSuccess, options.Bind("count", &handle));
+    EXPECT_EQ(second->Value(handle), 3);
+
+    // Options added later are absent from older snapshots
+
+    options.Add<double>("ratio", 0.5);
+    double ratio = 0;
+    EXPECT_EQ(jfern::CmdLineError::kDoesNotExist,
+              second->Get("ratio", &ratio));
+
+    // Deleting an option moves no other, so snapshots stay in step, and
+    // still hold the deleted option as of staging
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Delete("name"));
+    EXPECT_EQ(options.Current(), second);
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, second->Get("name", &name));
+    EXPECT_EQ(name, "kirby");
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, second->Get("count", &count));
+    EXPECT_EQ(count, 3);
+
+    // An option reusing the deleted one's slot is absent from the snapshot
+
+    options.Add<std::string>("host", "localhost");
+    EXPECT_EQ(jfern::CmdLineError::kDoesNotExist, second->Get("host", &name));
+
+    options.Publish(jfern::CommandLineOptions::Snapshot(*second));
+    options.Get("host", &name);
+    EXPECT_EQ(name, "localhost");
+}
+
+TEST(UserOptionsSnapshotTest, OutlivesOptions) {
+    using Options = jfern::CommandLineOptions;
+
+    std::shared_ptr<const Options::Snapshot> held;
+    Options copied, moved;
+
+    {
+        Options options;
+        options.Add<std::int32_t>("count", 1);
+        options.Add<std::string>("name", "none");
+
+        auto staged = options.Stage();
+        staged.Set("count", 2);
+        staged.Set<std::string>("name", "kirby");
+        options.Publish(std::move(staged));
+
+        held   = options.Current();
+        copied = options;
+        moved  = std::move(options);
+    }
+
+    // Snapshots look names up on their own, so none depends on the source
+
+    for (const auto& snapshot :
+         {held, copied.Current(), moved.Current()}) {
+        ASSERT_NE(snapshot, nullptr);
+
+        std::int32_t count = 0;
+        EXPECT_EQ(jfern::CmdLineError::kSuccess,
+                  snapshot->Get("count", &count));
+        EXPECT_EQ(count, 2);
+
+        std::string name;
+        EXPECT_EQ(jfern::CmdLineError::kSuccess,
+                  snapshot->Get("name", &name));
+        EXPECT_EQ(name, "kirby");
+        EXPECT_EQ(jfern::CmdLineError::kWrongType,
+                  snapshot->Get("name", &count));
+    }
+
+    // A snapshot staged from a copy also stands alone
+
+    auto staged = copied.Stage();
+    copied = Options();
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              staged.SetFromString("count", "3"));
+    std::int32_t count = 0;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, staged.Get("count", &count));
+    EXPECT_EQ(count, 3);
+}
+
+TEST(UserOptionsSnapshotTest, AssignAcrossResources) {
+    using Options = jfern::CommandLineOptions;
+
+    Options copied, moved;
+
+    {
+        std::pmr::monotonic_buffer_resource resource;
+
+        Options options(&resource);
+        options.Add<std::int32_t>("net.port", 80, "The port to listen on");
+        options.Add<std::string>("net.host", "localhost");
+        options.Add<bool>("verbose", false);
+        options.Set("net.port", 8080);
+        options.Publish();
+
+        copied = options;
+        moved  = std::move(options);
+    }
+
+    // Names, descriptions and the snapshot were copied out of the arena
+
+    for (Options* options : {&copied, &moved}) {
+        EXPECT_EQ(options->Resource(), std::pmr::get_default_resource());
+
+        std::int32_t port = 0;
+        EXPECT_EQ(jfern::CmdLineError::kSuccess,
+                  options->Get("net.port", &port));
+        EXPECT_EQ(port, 8080);
+
+        EXPECT_EQ(options->Names("net"),
+                  (std::vector<std::string>{"net.host", "net.port"}));
+
+        std::ostringstream os;
+        options->Print("program", os);
+        EXPECT_NE(os.str().find("The port to listen on"), std::string::npos);
+
+        auto snapshot = options->Current();
+        ASSERT_NE(snapshot, nullptr);
+        port = 0;
+        EXPECT_EQ(jfern::CmdLineError::kSuccess,
+                  snapshot->Get("net.port", &port));
+        EXPECT_EQ(port, 8080);
+
+        EXPECT_EQ(jfern::CmdLineError::kSuccess, options->Delete("verbose"));
+        EXPECT_EQ(jfern::CmdLineError::kSuccess,
+                  options->Add<bool>("verbose", true));
+    }
+}
+
+TEST(UserOptionsHandleTest, NoexceptOnlyWithoutAllocation) {
+    using Options = jfern::ConcurrentCommandLineOptions;
+
+    Options::OptionHandle<std::int32_t> count;
+    Options::OptionHandle<std::string> name;
+
+    // Copying a string may throw, so reading one must be allowed to
+
+    static_assert(noexcept(count.Value()), "int32 reads cannot throw");
+    static_assert(!noexcept(name.Value()), "string reads may throw");
+    static_assert(!noexcept(name.Default()), "string reads may throw");
+}
+
+TEST(UserOptionsHandleTest, SurvivesAddAndDelete) {
+    jfern::CommandLineOptions options;
+
+    for (int i = 0; i < 10; i++)
+        options.Add<std::int32_t>("opt" + std::to_string(i), i);
+
+    jfern::CommandLineOptions::OptionHandle<std::int32_t> first, last;
+    ASSERT_EQ(jfern::CmdLineError::kSuccess, options.Bind("opt0", &first));
+    ASSERT_EQ(jfern::CmdLineError::kSuccess, options.Bind("opt9", &last));
+
+    // Churn other options, reusing their slots
+
+    for (int i = 1; i < 9; i++)
+        options.Delete("opt" + std::to_string(i));
+
+    for (int i = 0; i < 100; i++)
+        options.Add<std::int32_t>("new" + std::to_string(i), -i);
+
+    options.Set("opt9", 90);
+
+    EXPECT_TRUE(first.Valid());
+    EXPECT_TRUE(last.Valid());
+    EXPECT_EQ(first.Value(), 0);
+    EXPECT_EQ(last.Value(), 90);
+
+    // A handle to a deleted option reports so, even once its slot is reused
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Delete("opt0"));
+    EXPECT_FALSE(first.Valid());
+
+    options.Add<std::int32_t>("reused", 7);
+    EXPECT_FALSE(first.Valid());
+
+    jfern::CommandLineOptions::OptionHandle<std::int32_t> reused;
+    ASSERT_EQ(jfern::CmdLineError::kSuccess, options.Bind("reused", &reused));
+    EXPECT_TRUE(reused.Valid());
+    EXPECT_EQ(reused.Value(), 7);
+
+    std::vector<std::string> names = options.Names("opt");
+    EXPECT_EQ(names, std::vector<std::string>({"opt9"}));
+
+    std::ostringstream os;
+    options.Print("program", os);
+    EXPECT_EQ(os.str().find("opt1"), std::string::npos);
+    EXPECT_NE(os.str().find("reused"), std::string::npos);
+}
+
+TEST(UserOptionsHandleTest, DeleteThenAdd) {
+    using Options = jfern::CommandLineOptions;
+
+    Options options;
+    options.Add<std::int32_t>("count", 1);
+    options.Add<std::string>("name", "kirby");
+
+    Options::OptionHandle<std::int32_t> count;
+    Options::OptionHandle<std::string> name;
+    ASSERT_EQ(jfern::CmdLineError::kSuccess, options.Bind("count", &count));
+    ASSERT_EQ(jfern::CmdLineError::kSuccess, options.Bind("name", &name));
+
+    Options::Overlay overlay(options);
+
+    // Each type has one slot, so the new options take the deleted ones'
+
+    options.Delete("count");
+    options.Delete("name");
+    options.Add<std::int32_t>("limit", 2);
+    options.Add<std::string>("host", "localhost");
+    options.Set("limit", 3);
+
+    EXPECT_EQ(count.Value(), 0);
+    EXPECT_EQ(count.Default(), 0);
+    EXPECT_EQ(name.Value(), "");
+    EXPECT_EQ(name.Default(), "");
+    name.Read([](const std::string& value) { EXPECT_TRUE(value.empty()); });
+
+    EXPECT_EQ(overlay.Value(count), 0);
+    EXPECT_EQ(overlay.Value(name), "");
+
+    // An unbound handle reads the same way
+
+    Options::OptionHandle<std::int32_t> unbound;
+    EXPECT_EQ(unbound.Value(), 0);
+}
+
+TEST(UserOptionsOverlayTest, LayersOverBase) {
+    using Options = jfern::CommandLineOptions;
+
+    Options base;
+    base.Add<std::int32_t>("limits.files", 1024);
+    base.Add<std::string>("name", "base");
+    base.Add<bool>("verbose", false);
+
+    Options::Overlay tenant(base);
+    EXPECT_EQ(tenant.Size(), 0u);
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              tenant.Set<std::int32_t>("limits.files", 64));
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              tenant.SetFromString("verbose", "true"));
+    EXPECT_EQ(tenant.Size(), 2u);
+    EXPECT_TRUE(tenant.Overridden("limits.files"));
+    EXPECT_FALSE(tenant.Overridden("name"));
+
+    EXPECT_EQ(jfern::CmdLineError::kWrongType,
+              tenant.Set<double>("limits.files", 1.0));
+    EXPECT_EQ(jfern::CmdLineError::kDoesNotExist,
+              tenant.Set<std::int32_t>("limits.procs", 1));
+    EXPECT_EQ(jfern::CmdLineError::kInvalidValue,
+              tenant.SetFromString("verbose", "maybe"));
+
+    std::int32_t files = 0;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              tenant.Get("limits.files", &files));
+    EXPECT_EQ(files, 64);
+    base.Get("limits.files", &files);
+    EXPECT_EQ(files, 1024);
+
+    // Options not overridden follow the base, even as it changes
+
+    base.Set<std::string>("name", "changed");
+
+    std::string name;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, tenant.Get("name", &name));
+    EXPECT_EQ(name, "changed");
+
+    Options::OptionHandle<bool> verbose;
+    ASSERT_EQ(jfern::CmdLineError::kSuccess, base.Bind("verbose", &verbose));
+    EXPECT_TRUE(tenant.Value(verbose));
+
+    // Copies are independent
+
+    Options::Overlay other(tenant);
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, other.Reset("verbose"));
+    EXPECT_FALSE(other.Value(verbose));
+    EXPECT_TRUE(tenant.Value(verbose));
+
+    // An override does not outlive its option in the base
+
+    base.Delete("limits.files");
+    base.Add<std::int32_t>("limits.files", 8);
+
+    tenant.Get("limits.files", &files);
+    EXPECT_EQ(files, 8);
+    EXPECT_FALSE(tenant.Overridden("limits.files"));
+    EXPECT_EQ(tenant.Size(), 1u);
+
+    // Only an override of the option itself can be reset
+
+    EXPECT_EQ(jfern::CmdLineError::kDoesNotExist,
+              tenant.Reset("limits.files"));
+    EXPECT_EQ(jfern::CmdLineError::kDoesNotExist, tenant.Reset("name"));
+    EXPECT_EQ(jfern::CmdLineError::kDoesNotExist, tenant.Reset("missing"));
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, tenant.Reset("verbose"));
+    EXPECT_EQ(tenant.Size(), 0u);
+}
+
+TEST(UserOptionsSaveTest, SaveAndLoad) {
+    using Options = jfern::CommandLineOptions;
+
+    auto original = std::make_unique<Options>();
+    original->Add<bool>("verbose", false, "Verbose output");
+    original->Add<std::int8_t>("level", -3);
+    original->Add<std::uint64_t>("limits.bytes", 1u << 20);
+    original->Add<double>("rate", 0.5, "Requests per second");
+    original->Add<std::string>("name", "default", "Who");
+    original->Add<std::string>("deleted", "");
+    original->Delete("deleted");
+
+    original->Set("verbose", true);
+    original->Set<std::string>("name", "kirby");
+
+    std::ostringstream blob;
+    ASSERT_EQ(jfern::CmdLineError::kSuccess, original->Save(blob, 42));
+
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "commandline_ut.snapshot";
+
+    std::ofstream(path, std::ios::binary) << blob.str();
+
+    std::ostringstream help;
+    original->Print("program", help);
+    original.reset();
+
+    auto check = [&](const Options& options) {
+        bool verbose = false;
+        EXPECT_EQ(jfern::CmdLineError::kSuccess,
+                  options.Get("verbose", &verbose));
+        EXPECT_TRUE(verbose);
+
+        std::int8_t level = 0;
+        EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Get("level", &level));
+        EXPECT_EQ(level, -3);
+
+        std::string name;
+        EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Get("name", &name));
+        EXPECT_EQ(name, "kirby");
+        EXPECT_EQ(jfern::CmdLineError::kSuccess,
+                  options.Default("name", &name));
+        EXPECT_EQ(name, "default");
+
+        EXPECT_FALSE(options.Exists("deleted"));
+        EXPECT_EQ(options.Names("limits."),
+                  std::vector<std::string>({"limits.bytes"}));
+
+        std::ostringstream os;
+        options.Print("program", os);
+        EXPECT_EQ(os.str(), help.str());
+    };
+
+    {
+        Options options;
+        EXPECT_EQ(jfern::CmdLineError::kSuccess,
+                  options.Restore(blob.str(), 42));
+        check(options);
+    }
+
+    // Names from a mapped file outlive the options that loaded them
+
+    std::unique_ptr<Options> copy;
+    {
+        Options options;
+        EXPECT_EQ(jfern::CmdLineError::kSuccess,
+                  options.Load(path.string(), 42));
+        check(options);
+
+        copy = std::make_unique<Options>(options);
+    }
+
+    check(*copy);
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(jfern::CmdLineError::kInvalidConfig,
+              Options().Load(path.string(), 42));
+
+    // Only an empty set of options can load a snapshot
+
+    EXPECT_EQ(jfern::CmdLineError::kDuplicate, copy->Restore(blob.str(), 42));
+
+    // A snapshot from another schema or a damaged one loads nothing
+
+    Options options;
+    EXPECT_EQ(jfern::CmdLineError::kInvalidConfig,
+              options.Restore(blob.str(), 43));
+
+    const std::string truncated = blob.str().substr(0, blob.str().size() - 1);
+    EXPECT_EQ(jfern::CmdLineError::kInvalidConfig,
+              options.Restore(truncated, 42));
+
+    // Damage the last value, so that every other option loads first
+
+    std::string damaged = blob.str();
+
+    jfern::internal::BlobHeader header;
+    std::memcpy(&header, damaged.data(), sizeof(header));
+    damaged[header.pool - 1] = '\xff';
+
+    EXPECT_EQ(jfern::CmdLineError::kInvalidConfig,
+              options.Restore(damaged, 42));
+
+    EXPECT_TRUE(options.Names().empty());
+}
+
+TEST(UserOptionsSaveTest, DamagedLoadLeavesNoTrace) {
+    using Options = jfern::CommandLineOptions;
+
+    Options original;
+    original.Add<std::int32_t>("count", 7);
+    original.Add<std::string>("name", "kirby", "Who");
+
+    std::ostringstream blob;
+    ASSERT_EQ(jfern::CmdLineError::kSuccess, original.Save(blob));
+
+    // Damage the last value, which is checked after every other
+
+    std::string damaged = blob.str();
+
+    jfern::internal::BlobHeader header;
+    std::memcpy(&header, damaged.data(), sizeof(header));
+    damaged[header.pool - 1] = '\xff';
+
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "commandline_damaged_ut.bin";
+
+    std::ofstream(path, std::ios::binary) << damaged;
+
+    CountingResource resource;
+    Options options(&resource);
+
+    const std::size_t outstanding = resource.outstanding;
+
+    // Neither the mapping nor any room for the options is kept
+
+    EXPECT_EQ(jfern::CmdLineError::kInvalidConfig,
+              options.Load(path.string()));
+    EXPECT_EQ(jfern::CmdLineError::kInvalidConfig, options.Restore(damaged));
+    EXPECT_EQ(resource.outstanding, outstanding);
+
+    std::filesystem::remove(path);
+
+    ASSERT_EQ(jfern::CmdLineError::kSuccess, options.Restore(blob.str()));
+
+    std::int32_t count = 0;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Get("count", &count));
+    EXPECT_EQ(count, 7);
+}
+
+TEST(UserOptionsNotifyTest, Subscribe) {
+    jfern::CommandLineOptions options;
+    options.Add<std::int32_t>("count", 1);
+    options.Add<std::uint16_t>("net.port", 0);
+    options.Add<std::string>("net.host", "");
+    options.Add<bool>("network", false);
+
+    std::vector<std::vector<std::string>> count_calls, net_calls, all_calls;
+
+    auto record = [](std::vector<std::vector<std::string>>* calls) {
+        return [calls](const std::vector<std::string>& names) {
+            calls->push_back(names);
+        };
+    };
+
+    std::size_t count_id = 0;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              options.Subscribe("count", record(&count_calls), &count_id));
+    EXPECT_EQ(jfern::CmdLineError::kDoesNotExist,
+              options.Subscribe("missing", record(&count_calls)));
+    EXPECT_EQ(jfern::CmdLineError::kEmptyName,
+              options.Subscribe(" ", record(&count_calls)));
+
+    const std::size_t net_id = options.SubscribeGroup("net",
+                                                      record(&net_calls));
+    options.SubscribeGroup("", record(&all_calls));
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Set("count", 2));
+
+    ASSERT_EQ(count_calls.size(), 1u);
+    EXPECT_EQ(count_calls[0], std::vector<std::string>({"count"}));
+    EXPECT_TRUE(net_calls.empty());
+    EXPECT_EQ(all_calls.size(), 1u);
+
+    // Assigning the same value is not a change
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Set("count", 2));
+    EXPECT_EQ(count_calls.size(), 1u);
+
+    // A group covers dotted names beneath it only
+
+    options.Set<bool>("network", true);
+    EXPECT_TRUE(net_calls.empty());
+
+    options.Set<std::uint16_t>("net.port", 80);
+    ASSERT_EQ(net_calls.size(), 1u);
+    EXPECT_EQ(net_calls[0], std::vector<std::string>({"net.port"}));
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Unsubscribe(count_id));
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Unsubscribe(net_id));
+    EXPECT_EQ(jfern::CmdLineError::kDoesNotExist,
+              options.Unsubscribe(net_id));
+
+    options.Set("count", 3);
+    options.SetFromString("net.port", "8080");
+    EXPECT_EQ(count_calls.size(), 1u);
+    EXPECT_EQ(net_calls.size(), 1u);
+    EXPECT_EQ(all_calls.size(), 5u);
+}
+
+TEST(UserOptionsNotifyTest, Batch) {
+    constexpr int kOptions = 2000;
+
+    jfern::CommandLineOptions options;
+    for (int i = 0; i < kOptions; i++)
+        options.Add<std::int32_t>("group.opt" + std::to_string(i), 0);
+    options.Add<std::int32_t>("other", 0);
+
+    std::vector<std::vector<std::string>> group_calls, other_calls;
+
+    options.SubscribeGroup("group",
+        [&](const std::vector<std::string>& names) {
+            group_calls.push_back(names);
+        });
+    options.Subscribe("other",
+        [&](const std::vector<std::string>& names) {
+            other_calls.push_back(names);
+        });
+
+    // Every change in a published snapshot arrives in one call
+
+    auto staged = options.Stage();
+    for (int i = 0; i < kOptions; i++)
+        staged.Set("group.opt" + std::to_string(i), i + 1);
+    options.Publish(std::move(staged));
+
+    ASSERT_EQ(group_calls.size(), 1u);
+    EXPECT_EQ(group_calls[0].size(), static_cast<std::size_t>(kOptions));
+    EXPECT_TRUE(std::is_sorted(group_calls[0].begin(),
+                               group_calls[0].end()));
+    EXPECT_TRUE(other_calls.empty());
+
+    // Repeated changes to one option within a batch are coalesced
+
+    options.BeginBatch();
+    options.BeginBatch();
+    options.Set("other", 1);
+    options.Set("other", 2);
+    options.Set("group.opt0", -1);
+    options.EndBatch();
+
+    EXPECT_TRUE(other_calls.empty());
+
+    options.EndBatch();
+
+    ASSERT_EQ(other_calls.size(), 1u);
+    EXPECT_EQ(other_calls[0], std::vector<std::string>({"other"}));
+    ASSERT_EQ(group_calls.size(), 2u);
+    EXPECT_EQ(group_calls[1], std::vector<std::string>({"group.opt0"}));
+}
+
+TEST(UserOptionsNotifyTest, Dispatcher) {
+    jfern::CommandLineOptions options;
+    options.Add<std::int32_t>("count", 0);
+
+    std::vector<std::function<void()>> queue;
+    options.SetDispatcher([&queue](std::function<void()> task) {
+        queue.push_back(std::move(task));
+    });
+
+    std::vector<std::string> received;
+    options.Subscribe("count", [&](const std::vector<std::string>& names) {
+        received.insert(received.end(), names.begin(), names.end());
+    });
+
+    options.Set("count", 1);
+    options.Set("count", 2);
+
+    EXPECT_TRUE(received.empty());
+    ASSERT_EQ(queue.size(), 2u);
+
+    for (auto& task : queue)
+        task();
+
+    EXPECT_EQ(received, std::vector<std::string>({"count", "count"}));
+}
+
+TEST(UserOptionsNotifyTest, NaNChangesOnce) {
+    jfern::CommandLineOptions options;
+    options.Add<double>("ratio", 1.0);
+
+    std::size_t calls = 0;
+    options.Subscribe("ratio", [&](const std::vector<std::string>&) {
+        calls++;
+    });
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Set("ratio", nan));
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Set("ratio", nan));
+    EXPECT_EQ(calls, 1u);
+
+    double ratio = 0;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Get("ratio", &ratio));
+    EXPECT_TRUE(std::isnan(ratio));
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Set("ratio", 2.0));
+    EXPECT_EQ(calls, 2u);
+}
+
+TEST(UserOptionsNotifyTest, ThrowingListener) {
+    using Options = jfern::CommandLineOptions;
+
+    Options options;
+    options.Add<std::int32_t>("count", 0);
+
+    bool fail = true;
+    std::vector<std::string> received;
+    options.Subscribe("count", [&](const std::vector<std::string>& names) {
+        if (fail)
+            throw std::runtime_error("listener failed");
+        received.insert(received.end(), names.begin(), names.end());
+    });
+
+    // A listener that throws leaves no batch open behind it
+
+    EXPECT_THROW(options.Set("count", 1), std::runtime_error);
+
+    fail = false;
+    options.Set("count", 2);
+    EXPECT_EQ(received, std::vector<std::string>({"count"}));
+
+    // Leaving a batch by an exception drops its notifications
+
+    received.clear();
+    EXPECT_THROW({
+        Options::Batch batch(&options);
+        options.Set("count", 3);
+        throw std::runtime_error("batch abandoned");
+    }, std::runtime_error);
+
+    EXPECT_TRUE(received.empty());
+
+    options.Set("count", 4);
+    EXPECT_EQ(received, std::vector<std::string>({"count"}));
+
+    // Copies do not take the listeners with them
+
+    received.clear();
+
+    Options copied(options);
+    copied.Set("count", 5);
+
+    Options assigned;
+    assigned = options;
+    assigned.Set("count", 6);
+
+    EXPECT_TRUE(received.empty());
+
+    std::int32_t count = 0;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, copied.Get("count", &count));
+    EXPECT_EQ(count, 5);
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, assigned.Get("count", &count));
+    EXPECT_EQ(count, 6);
+}
+
+TEST(ConcurrentUserOptionsTest, PublishWhileReading) {
+    jfern::ConcurrentCommandLineOptions options;
+    options.Add<std::int64_t>("low", 0);
+    options.Add<std::int64_t>("high", 0);
+    options.Add<std::string>("label", "0");
+    options.Publish();
+
+    constexpr int kPublishes = 500;
+
+    std::atomic<bool> done(false);
+    std::atomic<int>  mixed(0);
+
+    // Each publication sets all three values together, so a reader that sees
+    // them disagree has observed a mix of two snapshots
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&]() {
+            std::uint64_t last = 0;
+            while (!done.load()) {
+                auto snapshot = options.Current();
+
+                std::int64_t low = -1, high = -2;
+                std::string label;
+                snapshot->Get("low", &low);
+                snapshot->Get("high", &high);
+                snapshot->Get("label", &label);
+
+                if (low != high || label != std::to_string(low)) mixed++;
+                if (snapshot->Generation() < last) mixed++;
+                last = snapshot->Generation();
+            }
+        });
+    }
+
+    for (std::int64_t i = 1; i <= kPublishes; i++) {
+        auto snapshot = options.Stage();
+        snapshot.Set("low", i);
+        snapshot.Set("high", i);
+        snapshot.Set("label", std::to_string(i));
+        options.Publish(std::move(snapshot));
+    }
+
+    done = true;
+    for (auto& reader : readers)
+        reader.join();
+
+    EXPECT_EQ(mixed.load(), 0);
+    EXPECT_EQ(options.Current()->Generation(), kPublishes + 1u);
+}
+
+TEST_F(CommandLineTest, ParseNotifies) {
+    jfern::CommandLineOptions options;
+    options.Add<std::int32_t>("count", 1);
+    options.Add<std::string>("name", "none");
+    options.Add<bool>("verbose", false);
+
+    std::vector<std::vector<std::string>> calls;
+    options.SubscribeGroup("", [&](const std::vector<std::string>& names) {
+        calls.push_back(names);
+    });
+
+    int argc;
+    char** argv = CmdlineToArgv("program --count=7 --name=kirby --verbose",
+                                &argc);
+
+    jfern::CommandLine command_line(options);
+    EXPECT_TRUE(command_line.parse(argc, argv));
+
+    ASSERT_EQ(calls.size(), 1u);
+    EXPECT_EQ(calls[0],
+              std::vector<std::string>({"count", "name", "verbose"}));
+}
+
+TEST_F(CommandLineTest, ParseThrowingListener) {
+    jfern::CommandLineOptions options;
+    options.Add<std::int32_t>("count", 1);
+
+    bool fail = true;
+    std::size_t calls = 0;
+    options.Subscribe("count", [&](const std::vector<std::string>&) {
+        if (fail)
+            throw std::runtime_error("listener failed");
+        calls++;
+    });
+
+    int argc;
+    char** argv = CmdlineToArgv("program --count=7", &argc);
+
+    jfern::CommandLine command_line(options);
+    EXPECT_THROW(command_line.parse(argc, argv), std::runtime_error);
+
+    // The parse's batch was closed, so later changes are delivered
+
+    fail = false;
+    options.Set("count", 8);
+    EXPECT_EQ(calls, 1u);
+
+    EXPECT_TRUE(command_line.parse(argc, argv));
+    EXPECT_EQ(calls, 2u);
+}
+
+TEST_F(CommandLineTest, ParseConcurrent) {
+    jfern::ConcurrentCommandLineOptions options;
+    options.Add<std::int32_t>("count", 1);
+    options.Add<std::string>("name", "none");
+
+    int argc;
+    char** argv = CmdlineToArgv("program --count=7 --name kirby", &argc);
+
+    jfern::CommandLine command_line(options);
+    EXPECT_TRUE(command_line.parse(argc, argv));
+
+    std::int32_t count = 0;
+    std::string name;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Get("count", &count));
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Get("name", &name));
+    EXPECT_EQ(count, 7);
+    EXPECT_EQ(name, "kirby");
+}
+
+TEST_F(CommandLineTest, ParseMemoryResource) {
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "commandline_pmr_ut.ini";
+
+    std::ofstream(path) << "[storage]\nsize = 1024\n";
+
+    int argc;
+    char** argv = CmdlineToArgv("program --count=7 --verbose", &argc);
+
+    CountingResource resource;
+
+    // Anything that falls back on the default resource fails loudly
+
+    std::pmr::memory_resource* fallback =
+        std::pmr::set_default_resource(std::pmr::null_memory_resource());
+
+    {
+        jfern::CommandLineOptions options(&resource);
+        options.Add<std::int32_t>("count", 1, "How many");
+        options.Add<std::uint32_t>("storage.size", 0);
+        options.Add<bool>("verbose", false);
+
+        jfern::CommandLine command_line(options);
+        EXPECT_TRUE(command_line.parse(argc, argv, path.string()));
+        EXPECT_TRUE(command_line.reload(path.string()));
+
+        const jfern::CommandLineOptions copy(options);
+        EXPECT_EQ(copy.Resource(), &resource);
+
+        std::int32_t count = 0;
+        std::uint32_t size = 0;
+        EXPECT_EQ(jfern::CmdLineError::kSuccess, copy.Get("count", &count));
+        EXPECT_EQ(jfern::CmdLineError::kSuccess,
+                  options.Current()->Get("storage.size", &size));
+        EXPECT_EQ(count, 7);
+        EXPECT_EQ(size, 1024u);
+    }
+
+    std::pmr::set_default_resource(fallback);
+
+    EXPECT_GT(resource.allocations, 0u);
+    EXPECT_EQ(resource.outstanding, 0u);
+
+    std::filesystem::remove(path);
+}
+
+TEST_F(CommandLineTest, Complete) {
+    jfern::CommandLineOptions options;
+    options.Add<std::int32_t>("count", 1);
+    options.Add<bool>("verbose", false);
+
+    jfern::CommandLine command_line(options);
+
+    int argc;
+    char** argv = CmdlineToArgv("program --__complete=--c", &argc);
+
+    std::ostringstream os;
+    EXPECT_TRUE(command_line.complete(argc, argv, os));
+    EXPECT_EQ(os.str(), "--count=\n");
+
+    argv = CmdlineToArgv("program --count=7", &argc);
+    EXPECT_FALSE(command_line.complete(argc, argv, os));
+
+    os.str("");
+    jfern::CommandLine::completion_script(jfern::CommandLine::Shell::kBash,
+                                          "/usr/bin/my-program", os);
+    EXPECT_NE(os.str().find("complete -F _my_program_complete my-program\n"),
+              std::string::npos);
+
+    // Candidates are read a line at a time, so none is expanded as a glob
+
+    EXPECT_NE(os.str().find("mapfile -t COMPREPLY < <("), std::string::npos);
+
+    os.str("");
+    jfern::CommandLine::completion_script(jfern::CommandLine::Shell::kZsh,
+                                          "my-program", os);
+    EXPECT_EQ(os.str().find("#compdef my-program\n"), 0u);
+}
+
+TEST_F(CommandLineTest, Profile) {
+    using Phase = jfern::StartupProfile::Phase;
+
+    jfern::StartupProfile profile;
+
+    jfern::CommandLineOptions options(&profile);
+    EXPECT_EQ(options.Profile(), &profile);
+
+    options.Add<std::int32_t>("count", 1);
+    options.Add<std::string>("name", "none");
+
+    EXPECT_EQ(profile.Get(Phase::kRegister).calls, 2u);
+    EXPECT_GT(profile.Get(Phase::kRegister).allocations, 0u);
+    EXPECT_GT(profile.Get(Phase::kRegister).bytes, 0u);
+
+    int argc;
+    char** argv = CmdlineToArgv("program --count=7 --name=kirby --bogus",
+                                &argc);
+
+    jfern::CommandLine command_line(options);
+    EXPECT_FALSE(command_line.parse(argc, argv));
+
+    EXPECT_EQ(profile.Get(Phase::kTokenize).calls, 1u);
+    EXPECT_GT(profile.Get(Phase::kTokenize).allocations, 0u);
+    EXPECT_EQ(profile.Get(Phase::kResolve).calls, 3u);
+    EXPECT_EQ(profile.Get(Phase::kConvert).calls, 2u);
+    EXPECT_EQ(profile.Get(Phase::kAssign).calls, 2u);
+
+    std::ostringstream os;
+    profile.Report(os);
+    EXPECT_EQ(os.str().find("phase"), 0u);
+    EXPECT_NE(os.str().find("\nassign "), std::string::npos);
+    EXPECT_NE(os.str().find("\ntotal "), std::string::npos);
+
+    // Nothing is recorded once the profile is detached
+
+    profile.Reset();
+    options.SetProfile(nullptr);
+
+    argv = CmdlineToArgv("program --count=8", &argc);
+    EXPECT_TRUE(command_line.parse(argc, argv));
+
+    for (std::size_t i = 0; i < jfern::StartupProfile::kPhases; i++)
+        EXPECT_EQ(profile.Get(static_cast<Phase>(i)).calls, 0u);
+
+    // Asking on the command line reports to std::cerr for that parse alone
+
+    std::ostringstream report;
+    std::streambuf* cerr = std::cerr.rdbuf(report.rdbuf());
+
+    argv = CmdlineToArgv("program --count=9 --cmdline_profile", &argc);
+    EXPECT_TRUE(command_line.parse(argc, argv));
+
+    std::cerr.rdbuf(cerr);
+
+    EXPECT_NE(report.str().find("\nresolve "), std::string::npos);
+    EXPECT_EQ(options.Profile(), nullptr);
+
+    std::int32_t count = 0;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Get("count", &count));
+    EXPECT_EQ(count, 9);
+}
+
+TEST_F(CommandLineTest, ProfileRequest) {
+    using Phase = jfern::StartupProfile::Phase;
+
+    jfern::CommandLineOptions options;
+    options.Add<std::int32_t>("count", 1);
+
+    jfern::CommandLine command_line(options);
+
+    std::ostringstream report;
+    std::streambuf* cerr = std::cerr.rdbuf(report.rdbuf());
+
+    // The request may be spelled as a bool, and may be declined
+
+    int argc;
+    char** argv = CmdlineToArgv("program --cmdline_profile=1 --count=2",
+                                &argc);
+    EXPECT_TRUE(command_line.parse(argc, argv));
+    EXPECT_NE(report.str().find("\ntokenize "), std::string::npos);
+
+    report.str("");
+    argv = CmdlineToArgv("program --cmdline_profile=false --count=3", &argc);
+    EXPECT_TRUE(command_line.parse(argc, argv));
+    EXPECT_TRUE(report.str().empty());
+
+    argv = CmdlineToArgv("program --cmdline_profile=maybe", &argc);
+    EXPECT_FALSE(command_line.parse(argc, argv));
+    ASSERT_EQ(command_line.Errors().size(), 1u);
+    EXPECT_EQ(command_line.Errors()[0].name, "cmdline_profile");
+    EXPECT_EQ(command_line.Errors()[0].error,
+              jfern::CmdLineError::kInvalidValue);
+
+    // A profile made for the parse is detached even if a listener throws
+
+    options.Subscribe("count", [](const std::vector<std::string>&) {
+        throw std::runtime_error("listener failed");
+    });
+
+    argv = CmdlineToArgv("program --cmdline_profile --count=4", &argc);
+    EXPECT_THROW(command_line.parse(argc, argv), std::runtime_error);
+    EXPECT_EQ(options.Profile(), nullptr);
+
+    std::cerr.rdbuf(cerr);
+
+    // Listeners called when a parse's batch closes count as assigning
+
+    jfern::StartupProfile profile;
+    options.SetProfile(&profile);
+
+    argv = CmdlineToArgv("program --count=5", &argc);
+    EXPECT_THROW(command_line.parse(argc, argv), std::runtime_error);
+
+    EXPECT_EQ(profile.Get(Phase::kAssign).calls, 2u);
+}
+
+TEST(DelimiterIndexTest, MatchesStringFind) {
+    // Delimiters land on every offset within a block, including the first
+    // and last, and the text ends partway through a block
+
+    std::string text;
+    for (int i = 0; i < 1000; i++) {
+        const int c = (i * 7919) % 13;
+        text.push_back(c == 0 ? '=' : c == 1 ? '\n' : 'a' + c);
+    }
+
+    for (auto mode : { jfern::internal::DelimiterIndex::Mode::kScalar,
+                       jfern::internal::DelimiterIndex::Mode::kSimd }) {
+        const jfern::internal::DelimiterIndex index(text, mode);
+
+        for (std::size_t pos = 0; pos <= text.size(); pos++) {
+            EXPECT_EQ(index.NextNewline(pos), text.find('\n', pos));
+            EXPECT_EQ(index.NextEqual(pos, text.size()),
+                      text.find('=', pos));
+
+            const std::size_t end = std::min(pos + 70, text.size());
+            const std::size_t equal = text.find('=', pos);
+
+            EXPECT_EQ(index.NextEqual(pos, end),
+                      equal < end ? equal : std::string::npos);
+        }
+    }
+
+    const jfern::internal::DelimiterIndex empty("");
+    EXPECT_EQ(empty.NextNewline(0), std::string::npos);
+    EXPECT_EQ(empty.NextEqual(0, 0), std::string::npos);
+}
+
+TEST(StringArenaTest, Intern) {
+    jfern::internal::StringArena arena;
+
+    const std::string_view first = arena.Intern("first");
+    EXPECT_EQ(first, "first");
+    EXPECT_EQ(arena.Intern(std::string("first")).data(), first.data());
+    EXPECT_TRUE(arena.Intern("").empty());
+
+    // Views remain valid as blocks and the hash table grow
+
+    std::vector<std::string_view> views;
+    for (int i = 0; i < 5000; i++)
+        views.push_back(arena.Intern("option" + std::to_string(i)));
+
+    const std::string large(100000, 'x');
+    EXPECT_EQ(arena.Intern(large), large);
+
+    for (int i = 0; i < 5000; i++) {
+        EXPECT_EQ(views[i], "option" + std::to_string(i));
+        EXPECT_EQ(arena.Intern(views[i]).data(), views[i].data());
+    }
+
+    // A copy shares what was stored, but stores new strings separately
+
+    jfern::internal::StringArena copy(arena);
+    EXPECT_EQ(copy.Intern("first").data(), first.data());
+
+    const std::string_view second = copy.Intern("second");
+    EXPECT_NE(arena.Intern("second").data(), second.data());
+
+    arena = jfern::internal::StringArena();
+    EXPECT_EQ(first, "first");
+    EXPECT_EQ(second, "second");
+}
+
+TEST(PrefixIndexTest, MatchesSortedSet) {
+    // Names share prefixes at many depths, and some are prefixes of others
+
+    std::vector<std::string> names;
+    for (int i = 0; i < 400; i++) {
+        std::string name = "a";
+        for (int j = i; j > 0; j /= 3)
+            name += "ab."[j % 3];
+        names.push_back(name);
+    }
+
+    jfern::internal::PrefixIndex index;
+    std::set<std::string> expected;
+
+    auto check = [&](const std::string& prefix) {
+        std::pmr::vector<std::string_view> found;
+        index.Collect(prefix, &found);
+
+        std::vector<std::string> wanted;
+        for (const std::string& name : expected) {
+            if (name.compare(0, prefix.size(), prefix) == 0)
+                wanted.push_back(name);
+        }
+
+        EXPECT_EQ(std::vector<std::string>(found.begin(), found.end()),
+                  wanted) << prefix;
+    };
+
+    for (std::size_t i = 0; i < names.size(); i++) {
+        index.Insert(names[i]);
+        expected.insert(names[i]);
+
+        if (i % 3 == 0) {
+            const std::string& victim = names[(i * 7) % (i + 1)];
+            index.Erase(victim);
+            expected.erase(victim);
+        }
+
+        if (i % 50 == 0) {
+            for (const char* prefix : {"", "a", "aa", "ab.", "a.b",
+                                       "ac", "ab.ab", "b"}) {
+                check(prefix);
+            }
+        }
+    }
+
+    for (const std::string& name : names) {
+        index.Erase(name);
+        expected.erase(name);
+    }
+
+    check("");
+}
+
+TEST(FromStringTest, Integers) {
+    std::int8_t i8 = 0;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              jfern::internal::FromString(" -128 ", &i8));
+    EXPECT_EQ(i8, -128);
+
+    EXPECT_EQ(jfern::CmdLineError::kOutOfRange,
+              jfern::internal::FromString("128", &i8));
+    EXPECT_EQ(i8, -128);
+
+    std::uint16_t u16 = 0;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              jfern::internal::FromString("65535", &u16));
+    EXPECT_EQ(u16, 65535);
+
+    EXPECT_EQ(jfern::CmdLineError::kInvalidValue,
+              jfern::internal::FromString("-1", &u16));
+    EXPECT_EQ(jfern::CmdLineError::kOutOfRange,
+              jfern::internal::FromString("65536", &u16));
+
+    std::int64_t i64 = 0;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              jfern::internal::FromString("-9223372036854775808", &i64));
+    EXPECT_EQ(i64, INT64_MIN);
+
+    std::uint64_t u64 = 0;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              jfern::internal::FromString("18446744073709551615", &u64));
+    EXPECT_EQ(u64, UINT64_MAX);
+
+    EXPECT_EQ(jfern::CmdLineError::kInvalidValue,
+              jfern::internal::FromString("12abc", &u64));
+    EXPECT_EQ(jfern::CmdLineError::kInvalidValue,
+              jfern::internal::FromString("", &u64));
+}
+
+TEST(FromStringTest, FloatingPoint) {
+    float f = 0;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              jfern::internal::FromString("3.5", &f));
+    EXPECT_EQ(f, 3.5f);
+
+    EXPECT_EQ(jfern::CmdLineError::kOutOfRange,
+              jfern::internal::FromString("1e60", &f));
+
+    double d = 0;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              jfern::internal::FromString("-2.5e-3", &d));
+    EXPECT_EQ(d, -2.5e-3);
+
+    EXPECT_EQ(jfern::CmdLineError::kInvalidValue,
+              jfern::internal::FromString("1.0.0", &d));
+    EXPECT_EQ(jfern::CmdLineError::kInvalidValue,
+              jfern::internal::FromString("pi", &d));
+}
+
+TEST(FromStringTest, Bool) {
+    bool b = false;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              jfern::internal::FromString("", &b));
+    EXPECT_TRUE(b);
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              jfern::internal::FromString("FALSE", &b));
+    EXPECT_FALSE(b);
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              jfern::internal::FromString("1", &b));
+    EXPECT_TRUE(b);
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              jfern::internal::FromString("0", &b));
+    EXPECT_FALSE(b);
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              jfern::internal::FromString("True", &b));
+    EXPECT_TRUE(b);
+
+    EXPECT_EQ(jfern::CmdLineError::kInvalidValue,
+              jfern::internal::FromString("yes", &b));
+}
+
+TEST_F(CommandLineTest, Parse) {
+    jfern::CommandLineOptions options;
+    options.Add<bool>("bool_opt", false);
+    options.Add<std::int8_t>("i8_opt", 0);
+    options.Add<std::int16_t>("i16_opt", 0);
+    options.Add<std::int32_t>("i32_opt", 0);
+    options.Add<std::int64_t>("i64_opt", 0);
+    options.Add<std::uint8_t>("u8_opt", 0);
+    options.Add<std::uint16_t>("u16_opt", 0);
+    options.Add<std::uint32_t>("u32_opt", 0);
+    options.Add<std::uint64_t>("u64_opt", 0);
+    options.Add<float>("float_opt", 0);
+    options.Add<double>("double_opt", 0);
+    options.Add<std::string>("string_opt", "");
+
+    std::string cmdline = "program_name"
+                          " --bool_opt"
+                          " --i8_opt=-8"
+                          " --i16_opt=-16"
+                          " --i32_opt=-32"
+                          " --i64_opt=-64"
+                          " --u8_opt=8"
+                          " --u16_opt=16"
+                          " --u32_opt=32"
+                          " --u64_opt=64"
+                          " --float_opt=1.5"
+                          " --double_opt=2.5"
+                          " --string_opt=hello world";
+
+    int argc;
+    char** argv = CmdlineToArgv(cmdline, &argc);
+
+    jfern::CommandLine command_line(options);
+    ASSERT_TRUE(command_line.parse(argc, argv));
+    EXPECT_TRUE(command_line.Errors().empty());
+
+    bool b = false;
+    options.Get("bool_opt", &b);
+    EXPECT_TRUE(b);
+
+    std::int8_t i8 = 0;
+    options.Get("i8_opt", &i8);
+    EXPECT_EQ(i8, -8);
+
+    std::int64_t i64 = 0;
+    options.Get("i64_opt", &i64);
+    EXPECT_EQ(i64, -64);
+
+    std::uint8_t u8 = 0;
+    options.Get("u8_opt", &u8);
+    EXPECT_EQ(u8, 8);
+
+    std::uint64_t u64 = 0;
+    options.Get("u64_opt", &u64);
+    EXPECT_EQ(u64, 64u);
+
+    float f = 0;
+    options.Get("float_opt", &f);
+    EXPECT_EQ(f, 1.5f);
+
+    double d = 0;
+    options.Get("double_opt", &d);
+    EXPECT_EQ(d, 2.5);
+
+    std::string str;
+    options.Get("string_opt", &str);
+    EXPECT_EQ(str, "hello world");
+}
+
+TEST_F(CommandLineTest, ParseErrors) {
+    jfern::CommandLineOptions options;
+    options.Add<std::int8_t>("i8_opt", 1);
+    options.Add<double>("double_opt", 1.0);
+    options.Add<std::uint32_t>("u32_opt", 1);
+
+    int argc;
+    char** argv = CmdlineToArgv("program_name"
+                                " --i8_opt=300"
+                                " --double_opt=abc"
+                                " --u32_opt=7"
+                                " --unknown=1", &argc);
+
+    jfern::CommandLine command_line(options);
+    EXPECT_FALSE(command_line.parse(argc, argv));
+
+    const auto& errors = command_line.Errors();
+    ASSERT_EQ(errors.size(), 3u);
+
+    EXPECT_EQ(errors[0].name, "double_opt");
+    EXPECT_EQ(errors[0].error, jfern::CmdLineError::kInvalidValue);
+    EXPECT_EQ(errors[1].name, "i8_opt");
+    EXPECT_EQ(errors[1].error, jfern::CmdLineError::kOutOfRange);
+    EXPECT_EQ(errors[2].name, "unknown");
+    EXPECT_EQ(errors[2].error, jfern::CmdLineError::kDoesNotExist);
+
+    // Valid options are still applied, invalid ones are left alone
+
+    std::uint32_t u32 = 0;
+    options.Get("u32_opt", &u32);
+    EXPECT_EQ(u32, 7u);
+
+    std::int8_t i8 = 0;
+    options.Get("i8_opt", &i8);
+    EXPECT_EQ(i8, 1);
+
+    argv = CmdlineToArgv("program_name value", &argc);
+    EXPECT_FALSE(command_line.parse(argc, argv));
+    ASSERT_EQ(command_line.Errors().size(), 1u);
+    EXPECT_EQ(command_line.Errors()[0].error,
+              jfern::CmdLineError::kInvalidCmdLine);
+}
+
+TEST_F(CommandLineTest, ConfigFile) {
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "commandline_ut.ini";
+
+    std::ofstream(path)
+        << "# defaults for this program\n"
+        << "verbose = true\n"
+        << "rate=0.25\r\n"
+        << "; another comment\n"
+        << "\n"
+        << "[storage.cache]\n"
+        << "size = 1024  # bytes\n"
+        << "host = \"local host\" ; quoted\n"
+        << "tag = a#b ;c\n"
+        << "quoted = 'x # y'\n"
+        << "[ net ]\n"
+        << "port = 80\t#\n";
+
+    jfern::CommandLineOptions options;
+    options.Add<bool>("verbose", false);
+    options.Add<double>("rate", 1.0);
+    options.Add<std::uint32_t>("storage.cache.size", 0);
+    options.Add<std::string>("storage.cache.host", "");
+    options.Add<std::string>("storage.cache.tag", "");
+    options.Add<std::string>("storage.cache.quoted", "");
+    options.Add<std::uint16_t>("net.port", 0);
+    options.Add<std::string>("name", "default");
+
+    // The command line takes precedence over the config file
+
+    int argc;
+    char** argv = CmdlineToArgv("program_name --net.port=8080", &argc);
+
+    jfern::CommandLine command_line(options);
+    ASSERT_TRUE(command_line.parse(argc, argv, path.string()));
+
+    bool verbose = false;
+    options.Get("verbose", &verbose);
+    EXPECT_TRUE(verbose);
+
+    double rate = 0;
+    options.Get("rate", &rate);
+    EXPECT_EQ(rate, 0.25);
+
+    std::uint32_t size = 0;
+    options.Get("storage.cache.size", &size);
+    EXPECT_EQ(size, 1024u);
+
+    std::string host;
+    options.Get("storage.cache.host", &host);
+    EXPECT_EQ(host, "local host");
+
+    // Trailing comments are stripped, but not from within a value
+
+    std::string tag;
+    options.Get("storage.cache.tag", &tag);
+    EXPECT_EQ(tag, "a#b");
+
+    std::string quoted;
+    options.Get("storage.cache.quoted", &quoted);
+    EXPECT_EQ(quoted, "x # y");
+
+    std::uint16_t port = 0;
+    options.Get("net.port", &port);
+    EXPECT_EQ(port, 8080);
+
+    std::string name;
+    options.Get("name", &name);
+    EXPECT_EQ(name, "default");
+
+    // Errors
+
+    std::ofstream(path) << "verbose = true\nrate = fast\n";
+
+    argv = CmdlineToArgv("program_name", &argc);
+    EXPECT_FALSE(command_line.parse(argc, argv, path.string()));
+    ASSERT_EQ(command_line.Errors().size(), 1u);
+    EXPECT_EQ(command_line.Errors()[0].name, "rate");
+    EXPECT_EQ(command_line.Errors()[0].error,
+              jfern::CmdLineError::kInvalidValue);
+
+    std::ofstream(path) << "verbose\n";
+
+    EXPECT_FALSE(command_line.parse(argc, argv, path.string()));
+    ASSERT_EQ(command_line.Errors().size(), 1u);
+    EXPECT_EQ(command_line.Errors()[0].error,
+              jfern::CmdLineError::kInvalidConfig);
+
+    std::filesystem::remove(path);
+
+    EXPECT_FALSE(command_line.parse(argc, argv, path.string()));
+    ASSERT_EQ(command_line.Errors().size(), 1u);
+    EXPECT_EQ(command_line.Errors()[0].error,
+              jfern::CmdLineError::kInvalidConfig);
+}
+
+TEST_F(CommandLineTest, Reload) {
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "commandline_ut_reload.ini";
+
+    jfern::CommandLineOptions options;
+    options.Add<double>("rate", 1.0);
+    options.Add<std::uint16_t>("net.port", 0);
+    options.Add<std::string>("name", "default");
+
+    jfern::CommandLine command_line(options);
+
+    std::ofstream(path) << "rate = 0.5\n[net]\nport = 80\n";
+    ASSERT_TRUE(command_line.reload(path.string()));
+
+    auto first = options.Current();
+    ASSERT_NE(first, nullptr);
+
+    double rate = 0;
+    first->Get("rate", &rate);
+    EXPECT_EQ(rate, 0.5);
+
+    std::uint16_t port = 0;
+    options.Get("net.port", &port);
+    EXPECT_EQ(port, 80);
+
+    // A bad value rejects the whole file, leaving the old values in place
+
+    std::ofstream(path) << "rate = 0.75\n[net]\nport = 65536\n";
+    EXPECT_FALSE(command_line.reload(path.string()));
+
+    ASSERT_EQ(command_line.Errors().size(), 1u);
+    EXPECT_EQ(command_line.Errors()[0].name, "net.port");
+    EXPECT_EQ(command_line.Errors()[0].error,
+              jfern::CmdLineError::kOutOfRange);
+
+    EXPECT_EQ(options.Current(), first);
+    options.Get("rate", &rate);
+    EXPECT_EQ(rate, 0.5);
+
+    // Options missing from the file keep their current values
+
+    options.Set<std::string>("name", "kirby");
+
+    std::ofstream(path) << "rate = 0.75\n";
+    ASSERT_TRUE(command_line.reload(path.string()));
+
+    auto second = options.Current();
+    EXPECT_EQ(second->Generation(), first->Generation() + 1);
+
+    std::string name;
+    second->Get("rate", &rate);
+    second->Get("name", &name);
+    second->Get("net.port", &port);
+    EXPECT_EQ(rate, 0.75);
+    EXPECT_EQ(name, "kirby");
+    EXPECT_EQ(port, 80);
+
+    std::filesystem::remove(path);
+
+    EXPECT_FALSE(command_line.reload(path.string()));
+    ASSERT_EQ(command_line.Errors().size(), 1u);
+    EXPECT_EQ(command_line.Errors()[0].error,
+              jfern::CmdLineError::kInvalidConfig);
+}
+
+TEST_F(CommandLineTest, GetOptVal) {
+    std::string cmdline = "program_name"
+                          " --bool_opt=true"
+                          " --i8_opt=i8_value"
+                          " --i16_opt=i16_value"
+                          " --i32_opt=i32_value"
+                          " --i64_opt=i64_value"
+                          " --u8_opt=u8_value"
+                          " --u16_opt=u16_value"
+                          " --u32_opt=u32_value"
+                          " --u64_opt=u64_value"
+                          " --float_opt=float_value"
+                          " --double_opt=double_value"
+                          " --string_opt=string_value";
+
+    int argc;
+    char** argv = CmdlineToArgv(cmdline, &argc);
+
+    std::map<std::string, std::string> opt2val;
+    ASSERT_TRUE(jfern::CommandLine::GetOptVal(argc, argv, opt2val));
+
+    EXPECT_EQ(opt2val.size(), 12u);
+    EXPECT_EQ(jfern::superstring(opt2val["bool_opt"]).trim(), "true");
+    EXPECT_EQ(jfern::superstring(opt2val["i8_opt"]).trim(), "i8_value");
+    EXPECT_EQ(jfern::superstring(opt2val["i16_opt"]).trim(), "i16_value");
+    EXPECT_EQ(jfern::superstring(opt2val["i32_opt"]).trim(), "i32_value");
+    EXPECT_EQ(jfern::superstring(opt2val["i64_opt"]).trim(), "i64_value");
+    EXPECT_EQ(jfern::superstring(opt2val["u8_opt"]).trim(), "u8_value");
+    EXPECT_EQ(jfern::superstring(opt2val["u16_opt"]).trim(), "u16_value");
+    EXPECT_EQ(jfern::superstring(opt2val["u32_opt"]).trim(), "u32_value");
+    EXPECT_EQ(jfern::superstring(opt2val["u64_opt"]).trim(), "u64_value");
+    EXPECT_EQ(jfern::superstring(opt2val["float_opt"]).trim(), "float_value");
+    EXPECT_EQ(jfern::superstring(opt2val["double_opt"]).trim(), "double_value");
+    EXPECT_EQ(jfern::superstring(opt2val["string_opt"]).trim(), "string_value");
+}
+
+TEST_F(CommandLineTest, GetOptValArgBoundaries) {
+    std::string cmdline = "program_name"
+                          " --flag"
+                          " --msg=hello world"
+                          " --dashes=a--b=c"
+                          " --last=1";
+
+    int argc;
+    char** argv = CmdlineToArgv(cmdline, &argc);
+
+    std::map<std::string, std::string> opt2val;
+    ASSERT_TRUE(jfern::CommandLine::GetOptVal(argc, argv, opt2val));
+
+    EXPECT_EQ(opt2val.size(), 4u);
+    EXPECT_EQ(opt2val["flag"], "");
+    EXPECT_EQ(opt2val["msg"], "hello world");
+    EXPECT_EQ(opt2val["dashes"], "a--b=c");
+    EXPECT_EQ(opt2val["last"], "1");
+}
+
+TEST_F(CommandLineTest, GetOptValWithinArg) {
+    char program[] = "program_name";
+    char joined[]  = "--a=b --c=d";
+    char empty[]   = "--a=";
+    char value[]   = "x";
+
+    std::map<std::string, std::string> opt2val;
+
+    // One argument is one option, however many "--" it contains
+
+    char* argv1[] = { program, joined };
+    ASSERT_TRUE(jfern::CommandLine::GetOptVal(2, argv1, opt2val));
+
+    EXPECT_EQ(opt2val.size(), 1u);
+    EXPECT_EQ(opt2val["a"], "b --c=d");
+
+    // An empty value after '=' is not taken from the next argument
+
+    char* argv2[] = { program, empty, value };
+    EXPECT_FALSE(jfern::CommandLine::GetOptVal(3, argv2, opt2val));
+}
+
+TEST_F(CommandLineTest, GetOptValParsedArgs) {
+    std::string cmdline = "program_name"
+                          " --zeta=1"
+                          " --alpha=2"
+                          " --msg=hello big world"
+                          " --zeta=3";
+
+    int argc;
+    char** argv = CmdlineToArgv(cmdline, &argc);
+
+    jfern::ParsedArgs args;
+    ASSERT_TRUE(jfern::CommandLine::GetOptVal(argc, argv, args));
+
+    ASSERT_EQ(args.size(), 3u);
+
+    // Sorted by name, and the last of any duplicates wins
+
+    auto iter = args.begin();
+    EXPECT_EQ(iter->first, "alpha");
+    EXPECT_EQ((++iter)->first, "msg");
+    EXPECT_EQ((++iter)->first, "zeta");
+
+    auto zeta = args.Find("zeta");
+    ASSERT_NE(zeta, args.end());
+    EXPECT_EQ(zeta->second, "3");
+
+    // Values are views into argv
+
+    auto alpha = args.Find("alpha");
+    ASSERT_NE(alpha, args.end());
+    EXPECT_EQ(alpha->first.data(), argv[2] + 2);
+    EXPECT_EQ(alpha->second.data(), argv[2] + 8);
+
+    auto msg = args.Find("msg");
+    ASSERT_NE(msg, args.end());
+    EXPECT_EQ(msg->second, "hello big world");
+
+    EXPECT_EQ(args.Find("beta"), args.end());
+}
+
+TEST_F(CommandLineTest, ParsedArgsMoveAcrossResources) {
+    int argc;
+    char** argv = CmdlineToArgv("program_name"
+                                " --alpha=1"
+                                " --msg=hello big wide world"
+                                " --short=a b",
+                                &argc);
+
+    jfern::ParsedArgs args;
+
+    {
+        std::pmr::monotonic_buffer_resource resource;
+
+        jfern::ParsedArgs source(&resource);
+        ASSERT_TRUE(jfern::CommandLine::GetOptVal(argc, argv, source));
+
+        args = std::move(source);
+        EXPECT_TRUE(source.empty());
+    }
+
+    // The joined values were copied before their resource went away
+
+    ASSERT_EQ(args.size(), 3u);
+    EXPECT_EQ(args.Find("alpha")->second, "1");
+    EXPECT_EQ(args.Find("msg")->second, "hello big wide world");
+    EXPECT_EQ(args.Find("short")->second, "a b");
+}
+
+TEST_F(CommandLineTest, ResponseFile) {
+    const std::filesystem::path dir =
+        std::filesystem::temp_directory_path() / "commandline_ut_rsp";
+    std::filesystem::create_directories(dir / "nested");
+
+    std::ofstream(dir / "flags.rsp")
+        << "# a comment\n"
+        << "--alpha=1\n"
+        << "\n"
+        << "  --msg=hello world  \r\n"
+        << "@nested/more.rsp\n"
+        << "--beta=2";
+
+    std::ofstream(dir / "nested" / "more.rsp")
+        << "--gamma=3 # not a comment\n"
+        << "--beta=overridden\n";
+
+    const std::string cmdline = "program_name --alpha=0 @" +
+                                (dir / "flags.rsp").string() +
+                                " --delta=4";
+
+    int argc;
+    char** argv = CmdlineToArgv(cmdline, &argc);
+
+    jfern::ParsedArgs args;
+    ASSERT_TRUE(jfern::CommandLine::GetOptVal(argc, argv, args));
+
+    ASSERT_EQ(args.size(), 5u);
+    EXPECT_EQ(args.Find("alpha")->second, "1");
+    EXPECT_EQ(args.Find("beta")->second, "2");
+    EXPECT_EQ(args.Find("gamma")->second, "3 # not a comment");
+    EXPECT_EQ(args.Find("delta")->second, "4");
+    EXPECT_EQ(args.Find("msg")->second, "hello world");
+
+    // A file that includes itself, directly or indirectly
+
+    std::ofstream(dir / "cycle1.rsp") << "--a=1\n@cycle2.rsp\n";
+    std::ofstream(dir / "cycle2.rsp") << "--b=1\n@cycle1.rsp\n";
+
+    argv = CmdlineToArgv("program_name @" + (dir / "cycle1.rsp").string(),
+                         &argc);
+    EXPECT_FALSE(jfern::CommandLine::GetOptVal(argc, argv, args));
+
+    // Including the same file twice is fine
+
+    std::ofstream(dir / "twice.rsp") << "@nested/more.rsp\n@nested/more.rsp";
+
+    argv = CmdlineToArgv("program_name @" + (dir / "twice.rsp").string(),
+                         &argc);
+    EXPECT_TRUE(jfern::CommandLine::GetOptVal(argc, argv, args));
+    EXPECT_EQ(args.size(), 2u);
+
+    // Missing and empty files
+
+    argv = CmdlineToArgv("program_name @" + (dir / "missing.rsp").string(),
+                         &argc);
+    EXPECT_FALSE(jfern::CommandLine::GetOptVal(argc, argv, args));
+
+    std::ofstream(dir / "empty.rsp");
+
+    argv = CmdlineToArgv("program_name @" + (dir / "empty.rsp").string(),
+                         &argc);
+    EXPECT_TRUE(jfern::CommandLine::GetOptVal(argc, argv, args));
+    EXPECT_TRUE(args.empty());
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_F(CommandLineTest, GetOptValErrors) {
+    std::map<std::string, std::string> opt2val;
+    int argc;
+
+    EXPECT_FALSE(jfern::CommandLine::GetOptVal(0, nullptr, opt2val));
+
+    char** argv = CmdlineToArgv("program_name", &argc);
+    EXPECT_TRUE(jfern::CommandLine::GetOptVal(argc, argv, opt2val));
+    EXPECT_TRUE(opt2val.empty());
+
+    argv = CmdlineToArgv("program_name value --opt=1", &argc);
+    EXPECT_FALSE(jfern::CommandLine::GetOptVal(argc, argv, opt2val));
+
+    argv = CmdlineToArgv("program_name -- --opt=1", &argc);
+    EXPECT_FALSE(jfern::CommandLine::GetOptVal(argc, argv, opt2val));
+
+    argv = CmdlineToArgv("program_name --=1", &argc);
+    EXPECT_FALSE(jfern::CommandLine::GetOptVal(argc, argv, opt2val));
+
+    argv = CmdlineToArgv("program_name --opt=", &argc);
+    EXPECT_FALSE(jfern::CommandLine::GetOptVal(argc, argv, opt2val));
 }
 
 }  // namespace
@@ -0,0 +1,204 @@
+/**
+ *  \file   schema_ut.cc
+ *  \author Jason Fernandez
+ *  \date   10/16/2026
+ */
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "commandline/schema.h"
+
+namespace {
+constexpr auto kSchema = jfern::MakeSchema(
+    jfern::MakeOption<bool>("bool_opt", true, "a bool"),
+    jfern::MakeOption<std::int8_t>("i8_opt", -8),
+    jfern::MakeOption<std::int16_t>("i16_opt", -16),
+    jfern::MakeOption<std::int32_t>("i32_opt", -32),
+    jfern::MakeOption<std::int64_t>("i64_opt", -64),
+    jfern::MakeOption<std::uint8_t>("u8_opt", 8),
+    jfern::MakeOption<std::uint16_t>("u16_opt", 16),
+    jfern::MakeOption<std::uint32_t>("u32_opt", 32),
+    jfern::MakeOption<std::uint64_t>("u64_opt", 64),
+    jfern::MakeOption<float>("float_opt", 1.5f),
+    jfern::MakeOption<double>("double_opt", 2.5),
+    jfern::MakeOption<std::string>("string_opt", "hello", "a string"));
+
+static_assert(kSchema.Valid(), "schema has duplicate names");
+static_assert(kSchema.Find("bool_opt") == 0, "compile-time lookup");
+static_assert(kSchema.Find("string_opt") == 11, "compile-time lookup");
+static_assert(kSchema.Find("nope") == kSchema.npos, "compile-time lookup");
+static_assert(kSchema.Type(9) == "float", "compile-time type name");
+
+TEST(SchemaTest, Find) {
+    for (std::size_t i = 0; i < kSchema.kSize; i++) {
+        EXPECT_EQ(kSchema.Find(kSchema.Name(i)), i);
+    }
+
+    EXPECT_EQ(kSchema.Find(""), kSchema.npos);
+    EXPECT_EQ(kSchema.Find("bool_op"), kSchema.npos);
+    EXPECT_EQ(kSchema.Find("bool_opt "), kSchema.npos);
+
+    EXPECT_EQ(kSchema.Get<11>().description, "a string");
+}
+
+TEST(SchemaTest, Register) {
+    jfern::CommandLineOptions options;
+    ASSERT_EQ(jfern::CmdLineError::kSuccess, kSchema.Register(&options));
+
+    bool b = false;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Get("bool_opt", &b));
+    EXPECT_TRUE(b);
+
+    std::int64_t i64 = 0;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Get("i64_opt", &i64));
+    EXPECT_EQ(i64, -64);
+
+    double d = 0;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Get("double_opt", &d));
+    EXPECT_EQ(d, 2.5);
+
+    std::string s;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options.Get("string_opt", &s));
+    EXPECT_EQ(s, "hello");
+
+    // Registering twice collides with the existing names
+
+    EXPECT_EQ(jfern::CmdLineError::kDuplicate, kSchema.Register(&options));
+}
+
+TEST(SchemaTest, ParseThroughSchema) {
+    auto options = std::make_unique<jfern::CommandLineOptions>();
+    ASSERT_EQ(jfern::CmdLineError::kSuccess, kSchema.Register(options.get()));
+    ASSERT_EQ(jfern::CmdLineError::kSuccess,
+              options->Add<std::int32_t>("extra", 0));
+
+    char program[] = "program";
+    char i32[]     = "--i32_opt=7";
+    char str[]     = "--string_opt=world";
+    char extra[]   = "--extra=3";
+    char* argv[]   = { program, i32, str, extra };
+
+    jfern::CommandLine command_line(*options);
+    ASSERT_TRUE(command_line.parse(4, argv));
+
+    std::int32_t value = 0;
+    std::string s;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options->Get("i32_opt", &value));
+    EXPECT_EQ(value, 7);
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options->Get("string_opt", &s));
+    EXPECT_EQ(s, "world");
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options->Get("extra", &value));
+    EXPECT_EQ(value, 3);
+    EXPECT_EQ(jfern::CmdLineError::kWrongType, options->Get("bool_opt", &s));
+    EXPECT_EQ(jfern::CmdLineError::kDoesNotExist,
+              options->SetFromString("i32", "1"));
+
+    // A schema name deleted and added again with another type is found
+
+    ASSERT_EQ(jfern::CmdLineError::kSuccess, options->Delete("i32_opt"));
+    EXPECT_FALSE(options->Exists("i32_opt"));
+    EXPECT_EQ(jfern::CmdLineError::kDoesNotExist,
+              options->SetFromString("i32_opt", "1"));
+
+    ASSERT_EQ(jfern::CmdLineError::kSuccess,
+              options->Add<std::string>("i32_opt", "none"));
+    EXPECT_EQ(jfern::CmdLineError::kSuccess,
+              options->SetFromString("i32_opt", "abc"));
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, options->Get("i32_opt", &s));
+    EXPECT_EQ(s, "abc");
+
+    // Copies share the schema, which outlives the original
+
+    const jfern::CommandLineOptions copy(*options);
+    options.reset();
+
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, copy.Get("string_opt", &s));
+    EXPECT_EQ(s, "world");
+}
+
+TEST(SchemaTest, Fingerprint) {
+    constexpr auto kRenamed = jfern::MakeSchema(
+        jfern::MakeOption<bool>("verbose", false),
+        jfern::MakeOption<double>("ratio", 0.5));
+    constexpr auto kRetyped = jfern::MakeSchema(
+        jfern::MakeOption<bool>("verbose", false),
+        jfern::MakeOption<float>("rate", 0.5f));
+    constexpr auto kOriginal = jfern::MakeSchema(
+        jfern::MakeOption<bool>("verbose", false),
+        jfern::MakeOption<double>("rate", 0.5));
+    constexpr auto kRedefaulted = jfern::MakeSchema(
+        jfern::MakeOption<bool>("verbose", true, "Verbose output"),
+        jfern::MakeOption<double>("rate", 1.5));
+
+    static_assert(kOriginal.Fingerprint() == kRedefaulted.Fingerprint(),
+                  "defaults are not part of the fingerprint");
+
+    EXPECT_NE(kOriginal.Fingerprint(), kRenamed.Fingerprint());
+    EXPECT_NE(kOriginal.Fingerprint(), kRetyped.Fingerprint());
+
+    // A snapshot records the schema it was built from
+
+    jfern::CommandLineOptions options;
+    ASSERT_EQ(jfern::CmdLineError::kSuccess, kSchema.Register(&options));
+    options.Set<std::int32_t>("i32_opt", 7);
+
+    std::ostringstream blob;
+    ASSERT_EQ(jfern::CmdLineError::kSuccess,
+              options.Save(blob, kSchema.Fingerprint()));
+
+    jfern::CommandLineOptions loaded;
+    EXPECT_EQ(jfern::CmdLineError::kInvalidConfig,
+              loaded.Restore(blob.str(), kOriginal.Fingerprint()));
+    ASSERT_EQ(jfern::CmdLineError::kSuccess,
+              loaded.Restore(blob.str(), kSchema.Fingerprint()));
+
+    std::int32_t i32 = 0;
+    EXPECT_EQ(jfern::CmdLineError::kSuccess, loaded.Get("i32_opt", &i32));
+    EXPECT_EQ(i32, 7);
+}
+
+TEST(SchemaTest, Duplicates) {
+    constexpr auto schema = jfern::MakeSchema(
+        jfern::MakeOption<bool>("flag", true),
+        jfern::MakeOption<int>("other", 1),
+        jfern::MakeOption<double>("flag", 2.0));
+
+    static_assert(!schema.Valid(), "duplicate not detected");
+
+    jfern::CommandLineOptions options;
+    EXPECT_EQ(jfern::CmdLineError::kDuplicate, schema.Register(&options));
+    EXPECT_FALSE(options.Exists("flag"));
+}
+
+TEST(SchemaTest, LargePerfectHash) {
+    constexpr std::size_t kSize = 5000;
+
+    std::vector<std::string> storage;
+    std::array<std::string_view, kSize> names;
+
+    for (std::size_t i = 0; i < kSize; i++)
+        storage.push_back("storage.cache." + std::to_string(i));
+
+    for (std::size_t i = 0; i < kSize; i++)
+        names[i] = storage[i];
+
+    const auto hash = std::make_unique<jfern::PerfectHash<kSize>>(names);
+    ASSERT_TRUE(hash->Valid());
+
+    for (std::size_t i = 0; i < kSize; i++) {
+        EXPECT_EQ(hash->Find(names[i]), i);
+    }
+
+    EXPECT_EQ(hash->Find("storage.cache."), hash->npos);
+    EXPECT_EQ(hash->Find("storage.cache.5000"), hash->npos);
+}
+
+}  // namespace